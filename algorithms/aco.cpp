@@ -2,8 +2,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <stdexcept>
+#include <type_traits>
+
+#include "../core/local_search.hpp"
 
 namespace {
 
@@ -12,14 +16,10 @@ constexpr std::size_t CANDIDATE_LIST_SIZE = 20;
 constexpr std::size_t POLISHED_ANTS = 3;
 
 struct AntPath {
-    std::vector<City> path;
-    double cost = std::numeric_limits<double>::infinity();
+    Tour path;
+    std::int64_t cost = std::numeric_limits<std::int64_t>::max();
 };
 
-std::size_t matrix_index(std::size_t i, std::size_t j, std::size_t n) {
-    return i * n + j;
-}
-
 double transition_weight(double pheromone, double eta_beta, double alpha) {
     if (pheromone <= 0.0 || eta_beta <= 0.0 || !std::isfinite(pheromone) || !std::isfinite(eta_beta)) {
         return 0.0;
@@ -31,7 +31,7 @@ double transition_weight(double pheromone, double eta_beta, double alpha) {
     return std::isfinite(weight) && weight > 0.0 ? weight : 0.0;
 }
 
-std::size_t uniform_unvisited_city(const std::vector<bool>& used) {
+std::size_t uniform_unvisited_city(const std::vector<bool>& used, Rng& rng) {
     std::size_t available = 0;
 
     for (bool is_used: used) {
@@ -40,8 +40,7 @@ std::size_t uniform_unvisited_city(const std::vector<bool>& used) {
         }
     }
 
-    std::uniform_int_distribution<std::size_t> dist(0, available - 1);
-    std::size_t offset = dist(gen);
+    std::size_t offset = rng.below(available);
     for (std::size_t city = 0; city < used.size(); ++city) {
         if (used[city]) {
             continue;
@@ -55,33 +54,177 @@ std::size_t uniform_unvisited_city(const std::vector<bool>& used) {
     return used.size();
 }
 
-std::size_t select_from(const std::vector<std::size_t>& candidates, const std::vector<bool>& used,
-                        const std::vector<double>& pheromones, const std::vector<double>& eta_beta,
-                        std::size_t current, double alpha, std::size_t n) {
+double eta_beta_of(std::int64_t distance, double beta) {
+    return std::pow(1.0 / (static_cast<double>(distance) + 1e-6), beta);
+}
+
+// Pheromone and eta^beta for every city pair, used while they fit in memory. Both are symmetric,
+// so each is a packed triangle and a deposit touches one slot per edge.
+class DenseTrails {
+public:
+    template <typename Distance>
+    DenseTrails(const Distance& distance_matrix, double beta, double initial_pheromone)
+        : eta_beta_(distance_matrix.size()), pheromones_(distance_matrix.size(), initial_pheromone) {
+        const std::size_t n = distance_matrix.size();
+
+        for (std::size_t j = 0; j < n; ++j) {
+            double* column = eta_beta_.column(j);
+
+            for (std::size_t i = 0; i < j; ++i) {
+                column[i] = eta_beta_of(distance_matrix(i, j), beta);
+            }
+            column[j] = 0.0;
+        }
+    }
+
+    double weight(std::size_t from, std::size_t to, double alpha) const {
+        return transition_weight(pheromones_(from, to), eta_beta_(from, to), alpha);
+    }
+
+    double candidate_weight(std::size_t from, std::size_t, std::size_t to, double alpha) const {
+        return weight(from, to, alpha);
+    }
+
+    void evaporate(double keep) {
+        for (double& pheromone: pheromones_) {
+            pheromone *= keep;
+        }
+    }
+
+    void deposit(std::size_t from, std::size_t to, double amount) {
+        pheromones_.at(from, to) += amount;
+    }
+
+    void clamp(double low, double high) {
+        for (double& pheromone: pheromones_) {
+            pheromone = std::clamp(pheromone, low, high);
+        }
+    }
+
+private:
+    TriangularMatrix<double> eta_beta_;
+    TriangularMatrix<double> pheromones_;
+};
+
+// Pheromone and eta^beta stored only for candidate edges, for matrix-free instances. Each edge
+// in either endpoint's list has one trail, shared by both list entries, so it builds up whichever
+// way ants cross it. All other edges share one background trail that evaporates and is clamped
+// like the rest, and their eta^beta is computed on demand. Deposits on them are dropped: raising
+// the background would raise every edge outside the lists.
+template <typename Distance>
+class CandidateTrails {
+public:
+    CandidateTrails(const Distance& distances, const NeighborLists& candidates, double beta, double initial_pheromone)
+        : distances_(distances), candidates_(candidates), beta_(beta), eta_beta_(candidates.entries()),
+          trail_of_(candidates.entries()), background_(initial_pheromone) {
+        // An entry i -> j reuses the trail of j -> i when j's list holds i and j came first.
+        std::size_t trails = 0;
+        for (std::size_t city = 0; city < candidates.size(); ++city) {
+            const std::size_t offset = candidates.offset(city);
+            const NeighborRange list = candidates[city];
+            for (std::size_t slot = 0; slot < list.size(); ++slot) {
+                const std::size_t other = list[slot].city;
+                const std::size_t reverse = other < city ? find_entry(other, city) : NONE;
+
+                eta_beta_[offset + slot] = eta_beta_of(list[slot].distance, beta);
+                trail_of_[offset + slot] = reverse != NONE ? trail_of_[reverse] : static_cast<std::uint32_t>(trails++);
+            }
+        }
+        pheromones_.assign(trails, initial_pheromone);
+    }
+
+    double weight(std::size_t from, std::size_t to, double alpha) const {
+        std::size_t entry = find_entry(from, to);
+        if (entry == NONE) {
+            entry = find_entry(to, from);
+        }
+        if (entry != NONE) {
+            return transition_weight(pheromones_[trail_of_[entry]], eta_beta_[entry], alpha);
+        }
+
+        return transition_weight(background_, eta_beta_of(distances_(from, to), beta_), alpha);
+    }
+
+    double candidate_weight(std::size_t from, std::size_t slot, std::size_t, double alpha) const {
+        const std::size_t entry = candidates_.offset(from) + slot;
+
+        return transition_weight(pheromones_[trail_of_[entry]], eta_beta_[entry], alpha);
+    }
+
+    void evaporate(double keep) {
+        for (double& pheromone: pheromones_) {
+            pheromone *= keep;
+        }
+        background_ *= keep;
+    }
+
+    void deposit(std::size_t from, std::size_t to, double amount) {
+        std::size_t entry = find_entry(from, to);
+        if (entry == NONE) {
+            entry = find_entry(to, from);
+        }
+        if (entry != NONE) {
+            pheromones_[trail_of_[entry]] += amount;
+        }
+    }
+
+    void clamp(double low, double high) {
+        for (double& pheromone: pheromones_) {
+            pheromone = std::clamp(pheromone, low, high);
+        }
+        background_ = std::clamp(background_, low, high);
+    }
+
+private:
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    // Index of to in from's list among all entries, or NONE.
+    std::size_t find_entry(std::size_t from, std::size_t to) const {
+        const NeighborRange list = candidates_[from];
+        for (std::size_t slot = 0; slot < list.size(); ++slot) {
+            if (list[slot].city == to) {
+                return candidates_.offset(from) + slot;
+            }
+        }
+
+        return NONE;
+    }
+
+    const Distance& distances_;
+    const NeighborLists& candidates_;
+    double beta_;
+    std::vector<double> eta_beta_;
+    std::vector<std::uint32_t> trail_of_;
+    std::vector<double> pheromones_;
+    double background_;
+};
+
+template <typename Trails>
+std::size_t select_from(const NeighborRange& candidates, const std::vector<bool>& used, const Trails& trails,
+                        std::size_t current, double alpha, std::size_t n, Rng& rng) {
 
     double total_weight = 0.0;
 
     std::size_t last_eligible = n;
-    for (std::size_t city: candidates) {
+    for (std::size_t slot = 0; slot < candidates.size(); ++slot) {
+        const std::size_t city = candidates[slot].city;
         if (!used[city]) {
             last_eligible = city;
-            total_weight += transition_weight(pheromones[matrix_index(current, city, n)],
-                                               eta_beta[matrix_index(current, city, n)], alpha);
+            total_weight += trails.candidate_weight(current, slot, city, alpha);
         }
     }
     if (total_weight <= 0.0 || !std::isfinite(total_weight)) {
         return n;
     }
 
-    std::uniform_real_distribution<double> dist(0.0, total_weight);
-    double threshold = dist(gen);
+    double threshold = rng.uniform() * total_weight;
 
-    for (std::size_t city: candidates) {
+    for (std::size_t slot = 0; slot < candidates.size(); ++slot) {
+        const std::size_t city = candidates[slot].city;
         if (used[city]) {
             continue;
         }
-        threshold -= transition_weight(pheromones[matrix_index(current, city, n)],
-                                       eta_beta[matrix_index(current, city, n)], alpha);
+        threshold -= trails.candidate_weight(current, slot, city, alpha);
         if (threshold <= 0.0) {
             return city;
         }
@@ -90,8 +233,9 @@ std::size_t select_from(const std::vector<std::size_t>& candidates, const std::v
     return last_eligible;
 }
 
-std::size_t select_from_all(const std::vector<bool>& used, const std::vector<double>& pheromones,
-                            const std::vector<double>& eta_beta, std::size_t current, double alpha, std::size_t n) {
+template <typename Trails>
+std::size_t select_from_all(const std::vector<bool>& used, const Trails& trails, std::size_t current, double alpha,
+                            std::size_t n, Rng& rng) {
 
     double total_weight = 0.0;
     std::size_t last_eligible = n;
@@ -99,136 +243,124 @@ std::size_t select_from_all(const std::vector<bool>& used, const std::vector<dou
     for (std::size_t city = 0; city < n; ++city) {
         if (!used[city]) {
             last_eligible = city;
-            total_weight += transition_weight(pheromones[matrix_index(current, city, n)],
-                                               eta_beta[matrix_index(current, city, n)], alpha);
+            total_weight += trails.weight(current, city, alpha);
         }
     }
     if (total_weight <= 0.0 || !std::isfinite(total_weight)) {
-        return uniform_unvisited_city(used);
+        return uniform_unvisited_city(used, rng);
     }
 
-    std::uniform_real_distribution<double> dist(0.0, total_weight);
-    double threshold = dist(gen);
+    double threshold = rng.uniform() * total_weight;
     for (std::size_t city = 0; city < n; ++city) {
         if (used[city]) {
             continue;
         }
-        threshold -= transition_weight(pheromones[matrix_index(current, city, n)],
-                                       eta_beta[matrix_index(current, city, n)], alpha);
+        threshold -= trails.weight(current, city, alpha);
         if (threshold <= 0.0) {
             return city;
         }
     }
 
-    return last_eligible == n ? uniform_unvisited_city(used) : last_eligible;
+    return last_eligible == n ? uniform_unvisited_city(used, rng) : last_eligible;
 }
 
-bool build_path(const std::vector<City>& cities, std::vector<City>& path,
-                const std::vector<double>& pheromones, const std::vector<double>& eta_beta,
-                const std::vector<std::vector<std::size_t>>& candidate_lists, double alpha,
-                const RunController& controller) {
-    const std::size_t n = cities.size();
+template <typename Trails>
+bool build_path(std::size_t n, Tour& path, const Trails& trails,
+                const NeighborLists& candidate_lists, double alpha, const RunController& controller,
+                std::size_t& fallbacks, Rng& rng) {
     std::vector<bool> used(n, false);
-    used[static_cast<std::size_t>(path[0].id - 1)] = true;
+    used[path[0]] = true;
 
     while (path.size() < n) {
         if (controller.time_expired()) {
             return false;
         }
 
-        const auto current = static_cast<std::size_t>(path.back().id - 1);
-        std::size_t next = select_from(candidate_lists[current], used, pheromones, eta_beta, current, alpha, n);
+        const std::size_t current = path.back();
+        std::size_t next = select_from(candidate_lists[current], used, trails, current, alpha, n, rng);
 
         if (next == n) {
-            next = select_from_all(used, pheromones, eta_beta, current, alpha, n);
+            ++fallbacks;
+            next = select_from_all(used, trails, current, alpha, n, rng);
         }
-        path.push_back(cities[next]);
+        path.push_back(static_cast<std::uint32_t>(next));
         used[next] = true;
     }
 
     return true;
 }
 
-void precompute_eta_beta(const std::vector<double>& distance_matrix, std::vector<double>& eta_beta,
-                         double beta, std::size_t n) {
-    for (std::size_t i = 0; i < n; ++i) {
-        for (std::size_t j = 0; j < n; ++j) {
-            eta_beta[matrix_index(i, j, n)] =
-                (i == j) ? 0.0 : std::pow(1.0 / (distance_matrix[matrix_index(i, j, n)] + 1e-6), beta);
-        }
-    }
-}
-
-std::vector<City> nearest_neighbor_tour(const std::vector<City>& cities,
-                                        const std::vector<double>& distance_matrix, std::size_t n) {
+// Greedy tour from city 1. The nearest unvisited city is taken from the sorted candidate list
+// when one is left there; with nearest-k lists this matches a full scan because ties are ordered
+// by index.
+template <typename Distance>
+Tour nearest_neighbor_tour(const Distance& distance_matrix, const NeighborLists& candidate_lists, std::size_t n,
+                           std::size_t& fallbacks) {
     std::vector<bool> used(n, false);
     std::size_t current = 0;
 
     used[current] = true;
-    std::vector<City> tour;
+    Tour tour;
 
     tour.reserve(n);
-    tour.push_back(cities[current]);
+    tour.push_back(static_cast<std::uint32_t>(current));
 
     for (std::size_t step = 1; step < n; ++step) {
         std::size_t best_city = n;
-        double best_distance = std::numeric_limits<double>::infinity();
 
-        for (std::size_t city = 0; city < n; ++city) {
-            if (!used[city] && distance_matrix[matrix_index(current, city, n)] < best_distance) {
-                best_city = city;
-                best_distance = distance_matrix[matrix_index(current, city, n)];
+        for (const Neighbor& candidate: candidate_lists[current]) {
+            if (!used[candidate.city]) {
+                best_city = candidate.city;
+                break;
+            }
+        }
+
+        if (best_city == n) {
+            ++fallbacks;
+            std::int64_t best_distance = std::numeric_limits<std::int64_t>::max();
+
+            for (std::size_t city = 0; city < n; ++city) {
+                if (!used[city] && distance_matrix(current, city) < best_distance) {
+                    best_city = city;
+                    best_distance = distance_matrix(current, city);
+                }
             }
         }
 
         used[best_city] = true;
         current = best_city;
-        tour.push_back(cities[current]);
+        tour.push_back(static_cast<std::uint32_t>(current));
     }
 
     return tour;
 }
 
-void deposit_pheromone(std::vector<double>& pheromones, const std::vector<City>& path, std::size_t n, double amount) {
+template <typename Trails>
+void deposit_pheromone(Trails& trails, const Tour& path, double amount) {
     for (std::size_t k = 1; k < path.size(); ++k) {
-        const auto from = static_cast<std::size_t>(path[k - 1].id - 1);
-        const auto to = static_cast<std::size_t>(path[k].id - 1);
-        pheromones[matrix_index(from, to, n)] += amount;
-        pheromones[matrix_index(to, from, n)] += amount;
+        trails.deposit(path[k - 1], path[k], amount);
     }
 
-    const auto from = static_cast<std::size_t>(path.back().id - 1);
-    const auto to = static_cast<std::size_t>(path.front().id - 1);
-    pheromones[matrix_index(from, to, n)] += amount;
-    pheromones[matrix_index(to, from, n)] += amount;
+    trails.deposit(path.back(), path.front(), amount);
 }
 
-void clamp_pheromones(std::vector<double>& pheromones, double low, double high) {
-    if (!std::isfinite(high)) {
-        return;
-    }
-    for (double& pheromone: pheromones) {
-        pheromone = std::clamp(pheromone, low, high);
-    }
-}
-
-void run_one_epoch(const std::vector<City>& cities, const std::vector<double>& distance_matrix,
-                   const std::vector<double>& eta_beta, const std::vector<std::vector<std::size_t>>& candidate_lists,
-                   std::vector<double>& pheromones, std::vector<City>& best_tour, double& best_cost,
+template <typename Distance, typename Trails>
+void run_one_epoch(const Distance& distance_matrix, const NeighborLists& candidate_lists,
+                   Trails& trails, Tour& best_tour, std::int64_t& best_cost,
                    bool& has_ant_tour,
-                   std::size_t m, double alpha, double evaporation, bool use_two_opt, std::size_t n,
-                   const RunController& controller) {
+                   std::size_t m, double alpha, double evaporation, bool use_two_opt, LocalSearch local_search,
+                   std::size_t n,
+                   const RunController& controller, std::size_t& fallbacks, Rng& rng,
+                   LocalSearchWorkspace& workspace) {
 
     std::vector<AntPath> ants;
     ants.reserve(m);
 
-    std::uniform_int_distribution<std::size_t> start_dist(0, n - 1);
-
     for (std::size_t j = 0; j < m && !controller.time_expired(); ++j) {
         AntPath ant;
         ant.path.reserve(n);
-        ant.path.push_back(cities[start_dist(gen)]);
-        if (!build_path(cities, ant.path, pheromones, eta_beta, candidate_lists, alpha, controller)) {
+        ant.path.push_back(static_cast<std::uint32_t>(rng.below(n)));
+        if (!build_path(n, ant.path, trails, candidate_lists, alpha, controller, fallbacks, rng)) {
             break;
         }
         ants.emplace_back(std::move(ant));
@@ -248,8 +380,8 @@ void run_one_epoch(const std::vector<City>& cities, const std::vector<double>& d
     if (use_two_opt) {
         const std::size_t polished = std::min<std::size_t>(POLISHED_ANTS, ants.size());
         for (std::size_t j = 0; j < polished && !controller.time_expired(); ++j) {
-            two_opt_neighbors_unchecked(ants[j].path, distance_matrix, candidate_lists,
-                                        std::numeric_limits<std::size_t>::max(), &controller);
+            local_search_unchecked(ants[j].path, distance_matrix, candidate_lists, local_search,
+                                   std::numeric_limits<std::size_t>::max(), &controller, &workspace);
             ants[j].cost = total_cost_unchecked(ants[j].path, distance_matrix);
         }
         std::sort(ants.begin(), ants.end(), [](const AntPath& a, const AntPath& b) { return a.cost < b.cost; });
@@ -264,22 +396,22 @@ void run_one_epoch(const std::vector<City>& cities, const std::vector<double>& d
         return;
     }
 
-    for (double& pheromone: pheromones) {
-        pheromone *= (1.0 - evaporation);
+    trails.evaporate(1.0 - evaporation);
+    if (ants[0].cost > 0) {
+        deposit_pheromone(trails, ants[0].path, Q / static_cast<double>(ants[0].cost));
     }
-    if (ants[0].cost > 0.0 && std::isfinite(ants[0].cost)) {
-        deposit_pheromone(pheromones, ants[0].path, n, Q / ants[0].cost);
-    }
-    if (has_ant_tour && best_cost > 0.0 && std::isfinite(best_cost)) {
-        deposit_pheromone(pheromones, best_tour, n, Q / best_cost);
+    if (has_ant_tour && best_cost > 0) {
+        deposit_pheromone(trails, best_tour, Q / static_cast<double>(best_cost));
     }
 
-    const double high = evaporation > 0.0 && best_cost > 0.0 && std::isfinite(best_cost)
-                            ? 1.0 / (evaporation * best_cost)
+    const double high = evaporation > 0.0 && best_cost > 0
+                            ? 1.0 / (evaporation * static_cast<double>(best_cost))
                             : std::numeric_limits<double>::infinity();
     const double low = std::isfinite(high) ? high / static_cast<double>(2 * n) : 0.0;
 
-    clamp_pheromones(pheromones, low, high);
+    if (std::isfinite(high)) {
+        trails.clamp(low, high);
+    }
 }
 
 void validate(const AcoParams& p) {
@@ -297,42 +429,96 @@ void validate(const AcoParams& p) {
     }
 }
 
-}
-
-SolveResult aco_solve(std::vector<City>& cities, const AcoParams& params, const StopCondition& stop) {
-    validate_tour_input(cities, "Ant colony optimization");
-    validate(params);
+template <typename Distance, typename Trails>
+void run_colony(std::size_t n, const Distance& distance_matrix,
+                const NeighborLists& candidate_lists, Trails& trails, Tour& best_tour,
+                std::int64_t& best_cost, const AcoParams& params, RunController& controller,
+                std::size_t& fallbacks, Rng& rng) {
+    bool has_ant_tour = false;
+    LocalSearchWorkspace workspace;
 
-    RunController controller(stop);
-    controller.start();
+    const auto m = static_cast<std::size_t>(params.ants);
+    while (controller.next(best_cost)) {
+        run_one_epoch(distance_matrix, candidate_lists, trails, best_tour, best_cost,
+                      has_ant_tour, m, params.alpha, params.evaporation, params.two_opt, params.local_search, n,
+                      controller, fallbacks, rng, workspace);
+    }
+}
 
+template <typename Distance>
+SolveResult solve_with(std::vector<City>& cities, const std::vector<City>& city_by_id, const Distance& distance_matrix,
+                       const NeighborLists& candidate_lists, const AcoParams& params, RunController& controller,
+                       SolverContext& context) {
     const std::size_t n = cities.size();
-    std::vector<City> city_by_id = cities;
-    std::sort(city_by_id.begin(), city_by_id.end());
+    std::size_t fallbacks = 0;
 
-    const std::vector<double> distance_matrix = build_distance_matrix(city_by_id);
-    std::vector<double> eta_beta(n * n);
-    precompute_eta_beta(distance_matrix, eta_beta, params.beta, n);
-    const auto candidate_lists = build_neighbor_lists(distance_matrix, n, CANDIDATE_LIST_SIZE);
-
-    std::vector<City> best_tour = nearest_neighbor_tour(city_by_id, distance_matrix, n);
-    double best_cost = total_cost_unchecked(best_tour, distance_matrix);
-    const double initial_cost = best_cost;
-    bool has_ant_tour = false;
+    Tour best_tour = nearest_neighbor_tour(distance_matrix, candidate_lists, n, fallbacks);
+    std::int64_t best_cost = total_cost_unchecked(best_tour, distance_matrix);
+    const std::int64_t initial_cost = best_cost;
 
     const double initial_pheromone =
-        params.evaporation > 0.0 && std::isfinite(initial_cost) && initial_cost > 0.0
-            ? 1.0 / (params.evaporation * initial_cost)
+        params.evaporation > 0.0 && initial_cost > 0
+            ? 1.0 / (params.evaporation * static_cast<double>(initial_cost))
             : 1.0;
-    std::vector<double> pheromones(n * n, initial_pheromone);
 
-    const auto m = static_cast<std::size_t>(params.ants);
-    while (controller.next(best_cost)) {
-        run_one_epoch(city_by_id, distance_matrix, eta_beta, candidate_lists, pheromones, best_tour, best_cost,
-                      has_ant_tour, m, params.alpha, params.evaporation, params.two_opt, n, controller);
+    if constexpr (std::is_same_v<Distance, CoordinateDistance>) {
+        CandidateTrails<Distance> trails(distance_matrix, candidate_lists, params.beta, initial_pheromone);
+        run_colony(n, distance_matrix, candidate_lists, trails, best_tour, best_cost, params, controller,
+                   fallbacks, context.rng);
+    }
+    else {
+        DenseTrails trails(distance_matrix, params.beta, initial_pheromone);
+        run_colony(n, distance_matrix, candidate_lists, trails, best_tour, best_cost, params, controller,
+                   fallbacks, context.rng);
     }
 
-    cities = best_tour;
+    cities = to_cities(best_tour, city_by_id);
+
+    SolveResult result = controller.result(static_cast<double>(best_cost));
+    result.fallbacks = fallbacks;
+    return result;
+}
+
+SolveResult solve_prepared(std::vector<City>& cities, const PreparedInstance& instance, const AcoParams& params,
+                           RunController& controller, SolverContext& context) {
+    const NeighborLists& candidate_lists = instance.candidates(params.candidates, CANDIDATE_LIST_SIZE);
+
+    return instance.visit([&](const auto& distance_matrix) {
+        return solve_with(cities, instance.cities(), distance_matrix, candidate_lists, params, controller, context);
+    });
+}
+
+}
+
+InstanceRequirements aco_requirements(const AcoParams& params) {
+    InstanceRequirements requirements;
+
+    // Dense trails keep a pheromone and a weight per pair next to the distances.
+    requirements.pair_bytes = 2 * sizeof(double);
+    requirements.candidates.push_back({params.candidates, CANDIDATE_LIST_SIZE});
+
+    return requirements;
+}
+
+SolveResult aco_solve(std::vector<City>& cities, const AcoParams& params, const StopCondition& stop,
+                      SolverContext& context) {
+    validate_tour_input(cities, "Ant colony optimization");
+    validate(params);
+
+    RunController controller(stop);
+    controller.start();
+
+    const PreparedInstance instance(cities, aco_requirements(params));
+    return solve_prepared(cities, instance, params, controller, context);
+}
+
+SolveResult aco_solve(std::vector<City>& cities, const PreparedInstance& instance, const AcoParams& params,
+                      const StopCondition& stop, SolverContext& context) {
+    instance.validate_tour(cities, "Ant colony optimization");
+    validate(params);
+
+    RunController controller(stop);
+    controller.start();
 
-    return controller.result(best_cost);
+    return solve_prepared(cities, instance, params, controller, context);
 }
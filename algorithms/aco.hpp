@@ -4,8 +4,17 @@
 #include <vector>
 
 #include "../core/config.hpp"
+#include "../core/prepared_instance.hpp"
 #include "../core/tsp.hpp"
 
-SolveResult aco_solve(std::vector<City>& cities, const AcoParams& params, const StopCondition& stop);
+// Candidate lists and per-pair trail state aco_solve needs from a PreparedInstance.
+InstanceRequirements aco_requirements(const AcoParams& params);
+
+// Prepares distances and lists itself, inside the run's time budget.
+SolveResult aco_solve(std::vector<City>& cities, const AcoParams& params, const StopCondition& stop,
+                      SolverContext& context);
+// Starts from cities, a tour over instance's cities; preparation is not charged to the budget.
+SolveResult aco_solve(std::vector<City>& cities, const PreparedInstance& instance, const AcoParams& params,
+                      const StopCondition& stop, SolverContext& context);
 
 #endif
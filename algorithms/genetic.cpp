@@ -2,26 +2,124 @@
 
 #include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <stdexcept>
 
+#include "../core/local_search.hpp"
+
 namespace {
 
 constexpr std::size_t TOURNAMENT_SIZE = 3;
 constexpr std::size_t MEMETIC_TWO_OPT_MOVES = 25;
 constexpr std::size_t TWO_OPT_NEIGHBORS = 10;
 
-struct ScoredTour {
-    std::vector<City> tour;
-    double cost = 0.0;
+// The population as two flat size x n arrays of city indices with a cost per row: the current
+// generation and the one being bred, swapped when a generation completes. Sorting and selection
+// reorder ranks, not tours, so the only tours copied are the elites carried over; once built, the
+// arena allocates nothing. Rows that get polished also keep each city's position, indexed on first
+// use and then maintained by the search and carried over with the row, so polishing an elite again
+// does not index it again.
+class Population {
+public:
+    Population(std::size_t n, std::size_t size)
+        : n_(n), size_(size), cities_{std::vector<std::uint32_t>(n * size), std::vector<std::uint32_t>(n * size)},
+          costs_{std::vector<std::int64_t>(size), std::vector<std::int64_t>(size)},
+          indexed_{std::vector<char>(size), std::vector<char>(size)}, ranks_(size) {
+        std::iota(ranks_.begin(), ranks_.end(), std::size_t{0});
+    }
+
+    std::size_t size() const { return size_; }
+
+    // The individual at rank in the current generation; rank 0 is the best once sorted.
+    std::uint32_t* tour(std::size_t rank) { return cities_[current_].data() + ranks_[rank] * n_; }
+    std::int64_t& cost(std::size_t rank) { return costs_[current_][ranks_[rank]]; }
+    std::int64_t cost(std::size_t rank) const { return costs_[current_][ranks_[rank]]; }
+    // positions[city] is city's index in tour(rank); writes to the tour must keep it so.
+    std::uint32_t* positions(std::size_t rank) { return indexed(current_, ranks_[rank]); }
+
+    void sort() {
+        const auto& costs = costs_[current_];
+        std::sort(ranks_.begin(), ranks_.end(), [&](std::size_t a, std::size_t b) { return costs[a] < costs[b]; });
+    }
+
+    // Row slot of the generation being bred; writing it invalidates its positions.
+    std::uint32_t* next_tour(std::size_t slot) {
+        indexed_[1 - current_][slot] = 0;
+        return cities_[1 - current_].data() + slot * n_;
+    }
+    std::int64_t& next_cost(std::size_t slot) { return costs_[1 - current_][slot]; }
+    std::uint32_t* next_positions(std::size_t slot) { return indexed(1 - current_, slot); }
+
+    // Copies the individual at rank, with its positions when indexed, into slot of the next generation.
+    void carry_over(std::size_t rank, std::size_t slot) {
+        const std::size_t row = ranks_[rank];
+        const std::size_t next = 1 - current_;
+
+        std::copy_n(cities_[current_].data() + row * n_, n_, cities_[next].data() + slot * n_);
+        costs_[next][slot] = costs_[current_][row];
+        indexed_[next][slot] = indexed_[current_][row];
+        if (indexed_[next][slot]) {
+            std::copy_n(positions_[current_].data() + row * n_, n_, row_positions(next, slot));
+        }
+    }
+
+    // Makes the bred generation current, ranked in slot order.
+    void advance() {
+        current_ = 1 - current_;
+        std::iota(ranks_.begin(), ranks_.end(), std::size_t{0});
+    }
+
+private:
+    std::uint32_t* row_positions(std::size_t generation, std::size_t row) {
+        if (positions_[generation].empty()) {
+            positions_[generation].resize(n_ * size_);
+        }
+        return positions_[generation].data() + row * n_;
+    }
+
+    std::uint32_t* indexed(std::size_t generation, std::size_t row) {
+        std::uint32_t* positions = row_positions(generation, row);
+        if (!indexed_[generation][row]) {
+            const std::uint32_t* tour = cities_[generation].data() + row * n_;
+            for (std::size_t i = 0; i < n_; ++i) {
+                positions[tour[i]] = static_cast<std::uint32_t>(i);
+            }
+            indexed_[generation][row] = 1;
+        }
+        return positions;
+    }
+
+    std::size_t n_;
+    std::size_t size_;
+    std::vector<std::uint32_t> cities_[2];
+    std::vector<std::int64_t> costs_[2];
+    std::vector<std::uint32_t> positions_[2];
+    std::vector<char> indexed_[2];
+    std::vector<std::size_t> ranks_;
+    std::size_t current_ = 0;
 };
 
-std::size_t tournament_select(const std::vector<ScoredTour>& population) {
-    std::uniform_int_distribution<std::size_t> dist(0, population.size() - 1);
-    std::size_t best = dist(gen);
+template <typename Distance>
+std::int64_t row_cost(const std::uint32_t* tour, std::size_t n, const Distance& distance_matrix) {
+    if (n < 2) {
+        return 0;
+    }
+
+    std::int64_t total = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        total += distance_matrix(tour[i - 1], tour[i]);
+    }
+
+    return total + distance_matrix(tour[n - 1], tour[0]);
+}
+
+// Returns a rank in population.
+std::size_t tournament_select(const Population& population, Rng& rng) {
+    std::size_t best = rng.below(population.size());
 
     for (std::size_t i = 1; i < TOURNAMENT_SIZE; ++i) {
-        const std::size_t candidate = dist(gen);
-        if (population[candidate].cost < population[best].cost) {
+        const std::size_t candidate = rng.below(population.size());
+        if (population.cost(candidate) < population.cost(best)) {
             best = candidate;
         }
     }
@@ -29,80 +127,246 @@ std::size_t tournament_select(const std::vector<ScoredTour>& population) {
     return best;
 }
 
-void update_best(const ScoredTour& candidate, std::vector<City>& best_tour, double& best_cost) {
-    if (candidate.cost < best_cost) {
-        best_tour = candidate.tour;
-        best_cost = candidate.cost;
+void update_best(const std::uint32_t* tour, std::int64_t cost, Tour& best_tour, std::int64_t& best_cost) {
+    if (cost < best_cost) {
+        std::copy(tour, tour + best_tour.size(), best_tour.begin());
+        best_cost = cost;
     }
 }
 
-void polish(ScoredTour& candidate, const std::vector<double>& distance_matrix,
-            const std::vector<std::vector<std::size_t>>& neighbors, const RunController& controller) {
+// Searches from the workspace's seeds, or from every city when none were set, on the row in
+// place, and takes the applied moves' gain off its cost.
+template <typename Distance>
+void polish(std::uint32_t* tour, std::uint32_t* positions, std::int64_t& cost, std::size_t n,
+            const Distance& distance_matrix, const NeighborLists& neighbors, LocalSearch local_search,
+            const RunController& controller, LocalSearchWorkspace& workspace) {
+    array_local_search_unchecked(tour, positions, n, distance_matrix, neighbors, local_search, MEMETIC_TWO_OPT_MOVES,
+                                 &controller, workspace);
+    cost -= workspace.gain;
+}
+
+// Seeds workspace with both ends of every edge crossover and mutation rewired in child.
+void seed_rewired(const std::uint32_t* child, std::size_t n, const CrossoverWorkspace& crossover,
+                  LocalSearchWorkspace& workspace) {
+    for (std::size_t k = 0; k < crossover.rewired_count; ++k) {
+        const std::size_t position = crossover.rewired[k];
+        workspace.seed(child[(position + n - 1) % n]);
+        workspace.seed(child[position]);
+    }
+}
+
+// Placed-city marks of one crossover child for n <= CROSSOVER_BITMASK_CITIES.
+class BitmaskMarks {
+public:
+    explicit BitmaskMarks(std::size_t n) { std::fill_n(words_, (n + 63) / 64, std::uint64_t{0}); }
+
+    bool test(std::uint32_t city) const { return (words_[city >> 6] >> (city & 63)) & 1; }
+    void set(std::uint32_t city) { words_[city >> 6] |= std::uint64_t{1} << (city & 63); }
+
+private:
+    std::uint64_t words_[CROSSOVER_BITMASK_CITIES / 64];
+};
+
+// Placed-city marks kept as stamps in a workspace, for any n.
+class StampedMarks {
+public:
+    StampedMarks(CrossoverWorkspace& workspace, std::size_t n) {
+        std::vector<std::uint32_t>& visited = workspace.visited;
+        // New entries start at zero, below every stamp handed out so far.
+        if (visited.size() < n) {
+            visited.resize(n, 0);
+        }
+        if (++workspace.stamp == 0) {
+            std::fill(visited.begin(), visited.end(), 0);
+            workspace.stamp = 1;
+        }
+        visited_ = visited.data();
+        stamp_ = workspace.stamp;
+    }
+
+    bool test(std::uint32_t city) const { return visited_[city] == stamp_; }
+    void set(std::uint32_t city) { visited_[city] = stamp_; }
+
+private:
+    std::uint32_t* visited_;
+    std::uint32_t stamp_;
+};
+
+// Copies parent1[start..end] into output in place and fills the other slots with the remaining
+// cities in parent2's order. With Record, writes to rewired the child positions p whose edge from
+// p - 1 the child did not inherit from the parent those cities came from, and returns how many;
+// rewired needs n + 2 slots. marks is taken by value so that writes to the child cannot alias it.
+template <bool Record, typename Marks>
+std::size_t fill_order_crossover(const std::uint32_t* parent1, const std::uint32_t* parent2, std::size_t n,
+                                 std::size_t start, std::size_t end, std::uint32_t* output, std::uint32_t* rewired,
+                                 Marks marks) {
+    for (std::size_t i = start; i <= end; ++i) {
+        output[i] = parent1[i];
+        marks.set(parent1[i]);
+    }
+
+    const std::uint32_t* parent2_it = parent2;
+    const std::uint32_t* const parent2_end = parent2 + n;
+    std::size_t count = 0;
+    // Branch-free compaction: every city is written to the next free slot, which only advances
+    // past cities not placed yet; whether a city is placed is too random to predict. Consecutive
+    // filled slots hold a parent2 edge unless a placed city was skipped between them.
+    auto fill = [&](std::size_t first, std::size_t last) {
+        std::size_t i = first;
+        std::size_t skipped = 0;
+        while (i < last) {
+            if (parent2_it == parent2_end) {
+                throw std::runtime_error("Genetic crossover failed to construct a complete child tour.");
+            }
+            const std::uint32_t city = *parent2_it++;
+            const std::size_t placed = marks.test(city) ? 1 : 0;
+            output[i] = city;
+            if (Record) {
+                rewired[count] = static_cast<std::uint32_t>(i);
+                count += (1 - placed) & skipped & (i > first ? 1 : 0);
+                skipped = placed;
+            }
+            i += 1 - placed;
+            marks.set(city);
+        }
+    };
+
+    fill(0, start);
+    fill(end + 1, n);
+    if (!Record) {
+        return 0;
+    }
+
+    // The slice's two outer edges, and the closing edge (n - 1, 0): between two filled cities it
+    // is parent2's own closing edge only when both of parent2's ends were filled.
+    auto in_parent1 = [&](std::size_t i, std::uint32_t city) {
+        return parent1[(i + 1) % n] == city || parent1[(i + n - 1) % n] == city;
+    };
+    if (start > 0 && !in_parent1(start, output[start - 1])) {
+        rewired[count++] = static_cast<std::uint32_t>(start);
+    }
+    if (end + 1 < n && !in_parent1(end, output[end + 1])) {
+        rewired[count++] = static_cast<std::uint32_t>(end + 1);
+    }
+    const bool closing_inherited = start == 0       ? in_parent1(0, output[n - 1])
+                                   : end + 1 == n   ? in_parent1(n - 1, output[0])
+                                                    : output[0] == parent2[0] && output[n - 1] == parent2[n - 1];
+    if (!closing_inherited) {
+        rewired[count++] = 0;
+    }
+
+    return count;
+}
+
+// Swaps two cities or reverses the path between them. With workspace, also records the edges
+// it rewires after the crossover's, and moves the crossover's positions inside a reversal along.
+void mutate(std::uint32_t* order, std::size_t n, Rng& rng, CrossoverWorkspace* workspace) {
+    if (n < 2) {
+        return;
+    }
+
+    std::size_t i = rng.below(n);
+    std::size_t j = rng.below(n);
+
+    while (i == j) {
+        j = rng.below(n);
+    }
+
+    auto rewire = [&](std::size_t position) {
+        if (workspace && workspace->record_rewired) {
+            workspace->rewired[workspace->rewired_count++] = static_cast<std::uint32_t>(position % n);
+        }
+    };
+
+    if (rng.uniform() < 0.7) {
+        std::swap(order[i], order[j]);
+        for (const std::size_t position: {i, i + 1, j, j + 1}) {
+            rewire(position);
+        }
+        return;
+    }
+    if (i > j) {
+        std::swap(i, j);
+    }
 
-    if (two_opt_neighbors_unchecked(candidate.tour, distance_matrix, neighbors, MEMETIC_TWO_OPT_MOVES, &controller) > 0) {
-        candidate.cost = total_cost_unchecked(candidate.tour, distance_matrix);
+    std::reverse(order + i, order + j + 1);
+    if (workspace && workspace->record_rewired) {
+        for (std::size_t k = 0; k < workspace->rewired_count; ++k) {
+            std::uint32_t& position = workspace->rewired[k];
+            if (position > i && position <= j) {
+                position = static_cast<std::uint32_t>(i + j + 1 - position);
+            }
+        }
     }
+    rewire(i);
+    rewire(j + 1);
 }
 
-void run_one_generation(std::vector<ScoredTour>& population, std::size_t size, double mutation_rate,
-                        bool use_two_opt, const std::vector<double>& distance_matrix,
-                        const std::vector<std::vector<std::size_t>>& neighbors,
-                        std::vector<City>& best_tour, double& best_cost,
-                        const RunController& controller) {
+template <typename Distance>
+void run_one_generation(Population& population, double mutation_rate,
+                        bool use_two_opt, LocalSearch local_search, const Distance& distance_matrix,
+                        const NeighborLists& neighbors,
+                        Tour& best_tour, std::int64_t& best_cost,
+                        const RunController& controller, SolverContext& context, LocalSearchWorkspace& workspace,
+                        CrossoverWorkspace& crossover) {
+    const std::size_t size = population.size();
+    const std::size_t n = best_tour.size();
 
-    std::sort(population.begin(), population.end(), [](const ScoredTour& a, const ScoredTour& b) { return a.cost < b.cost; });
+    population.sort();
 
     if (use_two_opt) {
-        const std::size_t elites = std::min<std::size_t>(std::max<std::size_t>(1, population.size() / 10), population.size());
+        const std::size_t elites = std::min<std::size_t>(std::max<std::size_t>(1, size / 10), size);
 
         for (std::size_t j = 0; j < elites; ++j) {
             if (controller.time_expired()) {
                 break;
             }
-            polish(population[j], distance_matrix, neighbors, controller);
+            polish(population.tour(j), population.positions(j), population.cost(j), n, distance_matrix, neighbors,
+                   local_search, controller, workspace);
         }
 
-        std::sort(population.begin(), population.end(), [](const ScoredTour& a, const ScoredTour& b) { return a.cost < b.cost; });
+        population.sort();
     }
 
-    update_best(population[0], best_tour, best_cost);
-
-    std::vector<ScoredTour> next_population;
-    next_population.reserve(size);
+    update_best(population.tour(0), population.cost(0), best_tour, best_cost);
 
     const std::size_t elite_count = std::min<std::size_t>(size, std::max<std::size_t>(1, size / 10));
     for (std::size_t j = 0; j < elite_count; ++j) {
-        next_population.push_back(population[j]);
+        population.carry_over(j, j);
     }
+    std::size_t bred = elite_count;
 
-    std::bernoulli_distribution should_mutate(mutation_rate);
     std::size_t polished_children = 0;
     const std::size_t max_polished_children = use_two_opt ? std::max<std::size_t>(1, size / 20) : 0;
 
-    while (next_population.size() < size && !controller.time_expired()) {
-        const std::size_t parent1 = tournament_select(population);
-        const std::size_t parent2 = tournament_select(population);
+    while (bred < size && !controller.time_expired()) {
+        const std::uint32_t* parent1 = population.tour(tournament_select(population, context.rng));
+        const std::uint32_t* parent2 = population.tour(tournament_select(population, context.rng));
 
-        auto child_tour = genetic_order_crossover(population[parent1].tour, population[parent2].tour);
-        if (should_mutate(gen)) {
-            mutate_tour(child_tour);
+        std::uint32_t* child = population.next_tour(bred);
+        std::int64_t& child_cost = population.next_cost(bred);
+        crossover.record_rewired = use_two_opt && polished_children < max_polished_children;
+        genetic_order_crossover(parent1, parent2, n, child, crossover, context.rng);
+        if (context.rng.uniform() < mutation_rate) {
+            mutate(child, n, context.rng, &crossover);
         }
-
-        ScoredTour child{std::move(child_tour), 0.0};
-        child.cost = total_cost_unchecked(child.tour, distance_matrix);
-
-        if (use_two_opt && polished_children < max_polished_children) {
-            polish(child, distance_matrix, neighbors, controller);
+        child_cost = row_cost(child, n, distance_matrix);
+
+        // Only the cities around edges crossover and mutation rewired start active; a child made
+        // of inherited edges alone is left as it is and does not use up the budget.
+        if (crossover.record_rewired && crossover.rewired_count > 0) {
+            seed_rewired(child, n, crossover, workspace);
+            polish(child, population.next_positions(bred), child_cost, n, distance_matrix, neighbors, local_search,
+                   controller, workspace);
             ++polished_children;
         }
 
-        update_best(child, best_tour, best_cost);
-
-        next_population.emplace_back(std::move(child));
+        update_best(child, child_cost, best_tour, best_cost);
+        ++bred;
     }
 
-    if (next_population.size() == size) {
-        population = std::move(next_population);
+    if (bred == size) {
+        population.advance();
     }
 }
 
@@ -115,118 +379,127 @@ void validate(const GaParams& p) {
     }
 }
 
-}
-
-std::vector<City> genetic_order_crossover(const std::vector<City>& parent1, const std::vector<City>& parent2) {
-    if (parent1.empty() || parent1.size() != parent2.size()) {
-        throw std::invalid_argument("Genetic crossover requires non-empty parents with equal sizes.");
-    }
+template <typename Distance>
+SolveResult solve_with(std::vector<City>& cities, const std::vector<City>& city_by_index,
+                       const Distance& distance_matrix, const NeighborLists& neighbors, const GaParams& params,
+                       RunController& controller, SolverContext& context) {
+    const std::size_t size = static_cast<std::size_t>(params.population);
+    const Tour original_tour = to_tour(cities);
 
-    // Keep at least two slots for parent2 to avoid parent clones.
-    const std::size_t n = parent1.size();
-    std::uniform_int_distribution<std::size_t> length_dist(1, n >= 3 ? n - 2 : 1);
+    Tour shuffled = original_tour;
+    shuffle_range(shuffled.begin(), shuffled.end(), context.rng);
 
-    const std::size_t length = length_dist(gen);
-    std::uniform_int_distribution<std::size_t> start_dist(0, n - length);
+    const std::size_t n = original_tour.size();
+    Population population(n, size);
+    std::copy(original_tour.begin(), original_tour.end(), population.tour(0));
+    population.cost(0) = total_cost_unchecked(original_tour, distance_matrix);
 
-    const std::size_t start = start_dist(gen);
-    const std::size_t end = start + length - 1;
+    for (std::size_t i = 1; i < size; ++i) {
+        std::uint32_t* tour = population.tour(i);
+        std::copy(shuffled.begin(), shuffled.end(), tour);
+        shuffle_range(tour, tour + n, context.rng);
+        population.cost(i) = row_cost(tour, n, distance_matrix);
+    }
 
-    std::vector<City> output(parent1.size());
-    std::vector<bool> copied_position(parent1.size(), false);
-    std::vector<bool> used_city(parent1.size(), false);
+    Tour best_tour = original_tour;
+    std::int64_t best_cost = population.cost(0);
+    LocalSearchWorkspace workspace;
+    CrossoverWorkspace crossover;
 
-    for (std::size_t i = start; i <= end; ++i) {
-        output[i] = parent1[i];
-        copied_position[i] = true;
-        used_city[static_cast<std::size_t>(parent1[i].id - 1)] = true;
+    while (controller.next(best_cost)) {
+        run_one_generation(population, params.mutation, params.two_opt, params.local_search, distance_matrix,
+                           neighbors, best_tour, best_cost, controller, context, workspace, crossover);
     }
 
-    auto parent2_it = parent2.begin();
-    for (std::size_t i = 0; i < output.size(); ++i) {
-        if (copied_position[i]) {
-            continue;
-        }
-        while (parent2_it != parent2.end() && used_city[static_cast<std::size_t>(parent2_it->id - 1)]) {
-            ++parent2_it;
-        }
-        if (parent2_it == parent2.end()) {
-            throw std::runtime_error("Genetic crossover failed to construct a complete child tour.");
-        }
-        output[i] = *parent2_it;
-        used_city[static_cast<std::size_t>(parent2_it->id - 1)] = true;
+    if (params.two_opt && !controller.time_expired()) {
+        local_search_unchecked(best_tour, distance_matrix, neighbors, params.local_search, MEMETIC_TWO_OPT_MOVES,
+                               &controller, &workspace);
+        best_cost = total_cost_unchecked(best_tour, distance_matrix);
     }
+    cities = to_cities(best_tour, city_by_index);
 
-    return output;
+    return controller.result(static_cast<double>(best_cost));
 }
 
-void mutate_tour(std::vector<City>& order) {
-    if (order.size() < 2) {
-        return;
-    }
+SolveResult solve_prepared(std::vector<City>& cities, const PreparedInstance& instance, const GaParams& params,
+                           RunController& controller, SolverContext& context) {
+    static const NeighborLists no_neighbors;
+    const NeighborLists& neighbors =
+        params.two_opt ? instance.candidates(params.candidates, TWO_OPT_NEIGHBORS) : no_neighbors;
 
-    std::uniform_int_distribution<std::size_t> city_dist(0, order.size() - 1);
-    std::uniform_real_distribution<> mutation_type(0.0, 1.0);
+    return instance.visit([&](const auto& distance_matrix) {
+        return solve_with(cities, instance.cities(), distance_matrix, neighbors, params, controller, context);
+    });
+}
 
-    std::size_t i = city_dist(gen);
-    std::size_t j = city_dist(gen);
+}
 
-    while (i == j) {
-        j = city_dist(gen);
+Tour genetic_order_crossover(const Tour& parent1, const Tour& parent2, SolverContext& context) {
+    if (parent1.empty() || parent1.size() != parent2.size()) {
+        throw std::invalid_argument("Genetic crossover requires non-empty parents with equal sizes.");
     }
 
-    if (mutation_type(gen) < 0.7) {
-        std::swap(order[i], order[j]);
-        return;
+    Tour output(parent1.size());
+    CrossoverWorkspace workspace;
+    genetic_order_crossover(parent1.data(), parent2.data(), parent1.size(), output.data(), workspace, context.rng);
+
+    return output;
+}
+
+void genetic_order_crossover(const std::uint32_t* parent1, const std::uint32_t* parent2, std::size_t n,
+                             std::uint32_t* output, CrossoverWorkspace& workspace, Rng& rng) {
+    // Keep at least two slots for parent2 to avoid parent clones.
+    const std::size_t length = rng.between(1, n >= 3 ? n - 2 : 1);
+    const std::size_t start = rng.below(n - length + 1);
+    const std::size_t end = start + length - 1;
+
+    // Room for the crossover's edges and the four a mutation may add.
+    if (workspace.record_rewired && workspace.rewired.size() < n + 6) {
+        workspace.rewired.resize(n + 6);
     }
-    if (i > j) {
-        std::swap(i, j);
+    std::uint32_t* rewired = workspace.rewired.data();
+
+    auto fill = [&](auto marks) {
+        return workspace.record_rewired
+                   ? fill_order_crossover<true>(parent1, parent2, n, start, end, output, rewired, marks)
+                   : fill_order_crossover<false>(parent1, parent2, n, start, end, output, rewired, marks);
+    };
+    workspace.rewired_count =
+        n <= CROSSOVER_BITMASK_CITIES ? fill(BitmaskMarks(n)) : fill(StampedMarks(workspace, n));
+}
+
+void mutate_tour(Tour& order, SolverContext& context) {
+    mutate(order.data(), order.size(), context.rng, nullptr);
+}
+
+InstanceRequirements ga_requirements(const GaParams& params) {
+    InstanceRequirements requirements;
+    if (params.two_opt) {
+        requirements.candidates.push_back({params.candidates, TWO_OPT_NEIGHBORS});
     }
 
-    std::reverse(order.begin() + static_cast<std::ptrdiff_t>(i), order.begin() + static_cast<std::ptrdiff_t>(j + 1));
+    return requirements;
 }
 
-SolveResult ga_solve(std::vector<City>& cities, const GaParams& params, const StopCondition& stop) {
+SolveResult ga_solve(std::vector<City>& cities, const GaParams& params, const StopCondition& stop,
+                     SolverContext& context) {
     validate_tour_input(cities, "Genetic algorithm");
     validate(params);
 
     RunController controller(stop);
     controller.start();
 
-    const std::size_t size = static_cast<std::size_t>(params.population);
-    const std::vector<double> distance_matrix = build_distance_matrix(cities);
-    const std::vector<City> original_tour = cities;
-
-    const std::vector<std::vector<std::size_t>> neighbors =
-        params.two_opt ? build_neighbor_lists(distance_matrix, cities.size(), TWO_OPT_NEIGHBORS)
-                       : std::vector<std::vector<std::size_t>>{};
-
-    std::shuffle(cities.begin(), cities.end(), gen);
-
-    std::vector<ScoredTour> population;
-    population.reserve(size);
-    population.push_back({original_tour, total_cost_unchecked(original_tour, distance_matrix)});
-
-    std::vector<City> tmp;
-    for (std::size_t i = 1; i < size; ++i) {
-        tmp = cities;
-        std::shuffle(tmp.begin(), tmp.end(), gen);
-        population.push_back({tmp, total_cost_unchecked(tmp, distance_matrix)});
-    }
-
-    std::vector<City> best_tour = population.front().tour;
-    double best_cost = population.front().cost;
+    const PreparedInstance instance(cities, ga_requirements(params));
+    return solve_prepared(cities, instance, params, controller, context);
+}
 
-    while (controller.next(best_cost)) {
-        run_one_generation(population, size, params.mutation, params.two_opt, distance_matrix, neighbors,
-                           best_tour, best_cost, controller);
-    }
+SolveResult ga_solve(std::vector<City>& cities, const PreparedInstance& instance, const GaParams& params,
+                     const StopCondition& stop, SolverContext& context) {
+    instance.validate_tour(cities, "Genetic algorithm");
+    validate(params);
 
-    if (params.two_opt && !controller.time_expired()) {
-        two_opt_neighbors_unchecked(best_tour, distance_matrix, neighbors, MEMETIC_TWO_OPT_MOVES, &controller);
-        best_cost = total_cost_unchecked(best_tour, distance_matrix);
-    }
-    cities = best_tour;
+    RunController controller(stop);
+    controller.start();
 
-    return controller.result(best_cost);
+    return solve_prepared(cities, instance, params, controller, context);
 }
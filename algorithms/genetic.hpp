@@ -1,14 +1,49 @@
 #ifndef TSP_ALGORITHMS_GENETIC
 #define TSP_ALGORITHMS_GENETIC
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "../core/config.hpp"
+#include "../core/prepared_instance.hpp"
 #include "../core/tsp.hpp"
 
-std::vector<City> genetic_order_crossover(const std::vector<City>& parent1, const std::vector<City>& parent2);
-void mutate_tour(std::vector<City>& order);
+// Instances up to this size mark a crossover child's cities in an on-stack bitmask, cleared a
+// word at a time; larger ones use the stamps in a CrossoverWorkspace.
+inline constexpr std::size_t CROSSOVER_BITMASK_CITIES = 4096;
 
-SolveResult ga_solve(std::vector<City>& cities, const GaParams& params, const StopCondition& stop);
+// Scratch for order crossover. Above CROSSOVER_BITMASK_CITIES it keeps a stamp per city, where
+// visited[city] == stamp marks city as placed in the current child. Each child takes the next
+// stamp, so the array is only cleared when the stamp wraps around.
+struct CrossoverWorkspace {
+    std::vector<std::uint32_t> visited;
+    std::uint32_t stamp = 0;
+
+    // With record_rewired, the first rewired_count entries are the child positions p whose edge
+    // from position p - 1 (cyclically) the last child did not inherit from the parent those cities
+    // came from: the edges crossover rewired, found while filling the child. Positions may repeat.
+    // Recording costs the crossover about a third of its speed, so it is off by default.
+    bool record_rewired = false;
+    std::vector<std::uint32_t> rewired;
+    std::size_t rewired_count = 0;
+};
+
+Tour genetic_order_crossover(const Tour& parent1, const Tour& parent2, SolverContext& context);
+// The same over n-city tours stored as plain arrays, into output (n slots, aliasing neither
+// parent). Allocates nothing once workspace has grown to n cities.
+void genetic_order_crossover(const std::uint32_t* parent1, const std::uint32_t* parent2, std::size_t n,
+                             std::uint32_t* output, CrossoverWorkspace& workspace, Rng& rng);
+void mutate_tour(Tour& order, SolverContext& context);
+
+// Candidate lists ga_solve reads from a PreparedInstance.
+InstanceRequirements ga_requirements(const GaParams& params);
+
+// Prepares distances and lists itself, inside the run's time budget.
+SolveResult ga_solve(std::vector<City>& cities, const GaParams& params, const StopCondition& stop,
+                     SolverContext& context);
+// Starts from cities, a tour over instance's cities; preparation is not charged to the budget.
+SolveResult ga_solve(std::vector<City>& cities, const PreparedInstance& instance, const GaParams& params,
+                     const StopCondition& stop, SolverContext& context);
 
 #endif
@@ -1,21 +1,46 @@
 #include "sa.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../core/array_tour.hpp"
+#include "../core/distance_kernels.hpp"
+#include "../core/local_search.hpp"
 
 namespace {
 
 constexpr std::size_t TIME_CHECK_INTERVAL = 64;
+// Candidate list size for both the neighbor moves and the final 2-opt.
 constexpr std::size_t TWO_OPT_NEIGHBORS = 10;
 constexpr std::size_t TWO_OPT_MOVES = 25;
-
-std::pair<std::size_t, std::size_t> random_segment(std::size_t city_count) {
-    std::uniform_int_distribution<std::size_t> dist(0, city_count - 1);
-    std::size_t a = dist(gen);
-    std::size_t b = dist(gen);
+// Adaptive schedule: proposals sampled to calibrate the temperatures, the fewest uphill ones that
+// calibration trusts, and the share of the remaining time the planned chains may use.
+constexpr std::size_t CALIBRATION_SAMPLES = 1000;
+constexpr std::size_t MIN_CALIBRATION_DELTAS = 16;
+constexpr double TIME_BUDGET_SHARE = 0.95;
+// Parallel tempering: steps each replica runs between exchanges, and how many times hotter the
+// hottest rung of the ladder is than the coldest.
+constexpr std::size_t SWAP_INTERVAL = 10000;
+constexpr double LADDER_SPREAD = 1.2;
+// Random bits per Metropolis threshold drawn from the table of exponential quantiles.
+constexpr unsigned THRESHOLD_BITS = 12;
+
+std::pair<std::size_t, std::size_t> random_segment(std::size_t city_count, Rng& rng) {
+    std::size_t a = rng.below(city_count);
+    std::size_t b = rng.below(city_count);
     while (a == b) {
-        b = dist(gen);
+        b = rng.below(city_count);
     }
     if (a > b) {
         std::swap(a, b);
@@ -23,9 +48,284 @@ std::pair<std::size_t, std::size_t> random_segment(std::size_t city_count) {
     return {a, b};
 }
 
-bool accept_worse(double probability) {
-    std::uniform_real_distribution<> dist(0.0, 1.0);
-    return probability >= dist(gen);
+bool accept_worse(double probability, Rng& rng) {
+    return probability >= rng.uniform();
+}
+
+// Chains run side by side by parallel tempering; 0 asks for one per hardware thread.
+std::size_t replica_count(const SaParams& params) {
+    if (params.replicas == 0) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<std::size_t>(params.replicas);
+}
+
+bool uses_neighbors(const SaParams& params) {
+    return params.two_opt || params.moves == SaMoves::Neighbor;
+}
+
+bool accept(std::int64_t delta, double temperature, Rng& rng) {
+    return delta < 0 || accept_worse(std::exp(-static_cast<double>(delta) / temperature), rng);
+}
+
+// A move a chain has accepted but not yet applied. Reversal reverses array positions a..b. TwoOpt
+// turns edges (a, b) and (c, d) into (a, c) and (b, d). OrOpt moves the path a..b between the
+// adjacent cities c and d, as b..a next to c when reversed.
+struct ChainMove {
+    enum Kind : std::uint8_t { None, Reversal, TwoOpt, OrOpt };
+
+    Kind kind = None;
+    bool reversed = false;
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+    std::uint32_t c = 0;
+    std::uint32_t d = 0;
+};
+
+template <typename TourStore>
+void apply_move(TourStore& tour, const ChainMove& move) {
+    switch (move.kind) {
+        case ChainMove::TwoOpt:
+            if (tour.next(move.a) == move.b) {
+                tour.reverse(move.b, move.c);
+            } else {
+                tour.reverse(move.c, move.b);
+            }
+            break;
+        case ChainMove::OrOpt:
+            if (tour.next(move.c) == move.d) {
+                tour.move_segment(move.a, move.b, move.c, move.reversed);
+            } else {
+                tour.move_segment(move.b, move.a, move.d, move.reversed);
+            }
+            break;
+        case ChainMove::None:
+        case ChainMove::Reversal:
+            break;
+    }
+}
+
+ChainMove make_move(ChainMove::Kind kind, std::size_t a, std::size_t b, std::size_t c, std::size_t d,
+                    bool reversed = false) {
+    return {kind, reversed, static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(b),
+            static_cast<std::uint32_t>(c), static_cast<std::uint32_t>(d)};
+}
+
+// Reverses a uniformly random segment of tour if the Metropolis test accepts it: one proposal, one
+// delta and, for an uphill move, one exp.
+template <typename Distance>
+std::int64_t propose_reversal(const Tour& tour, const Distance& distance_matrix, double temperature, Rng& rng,
+                              ChainMove& move) {
+    const auto [start, end] = random_segment(tour.size(), rng);
+    const std::int64_t delta = tour_reversal_delta(tour, distance_matrix, start, end);
+    if (accept(delta, temperature, rng)) {
+        move = make_move(ChainMove::Reversal, start, end, 0, 0);
+    }
+    return delta;
+}
+
+void apply_reversal(Tour& tour, const ChainMove& move) {
+    std::reverse(tour.begin() + static_cast<std::ptrdiff_t>(move.a), tour.begin() + static_cast<std::ptrdiff_t>(move.b + 1));
+}
+
+// Quantiles of the unit exponential, E = -ln(u) at the midpoints of 2^THRESHOLD_BITS equal slices
+// of u. A move of change delta at temperature T passes the Metropolis test when delta <= T * E, so
+// a random entry replaces the uniform draw and the exp, with acceptance probabilities off by at
+// most one slice.
+const std::vector<double>& exponential_quantiles() {
+    static const std::vector<double> quantiles = [] {
+        std::vector<double> values(std::size_t{1} << THRESHOLD_BITS);
+        for (std::size_t k = 0; k < values.size(); ++k) {
+            values[k] = -std::log((static_cast<double>(k) + 0.5) / static_cast<double>(values.size()));
+        }
+        return values;
+    }();
+    return quantiles;
+}
+
+// Deltas of a batch of reversals: the gather kernels for dense and packed matrices, lookups for
+// coordinates.
+template <typename Distance>
+void batch_deltas(const Distance& distance_matrix, const std::uint32_t* a, const std::uint32_t* b,
+                  const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    auto dist = [&](std::size_t from, std::size_t to) { return std::int64_t{distance_matrix(from, to)}; };
+
+    for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+        out[k] = dist(a[k], c[k]) + dist(b[k], d[k]) - dist(a[k], b[k]) - dist(c[k], d[k]);
+    }
+}
+
+void batch_deltas(const DistanceMatrix<std::int32_t>& distance_matrix, const std::uint32_t* a, const std::uint32_t* b,
+                  const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    reversal_deltas(distance_matrix.row(0), distance_matrix.size(), a, b, c, d, out);
+}
+
+void batch_deltas(const DistanceMatrix<std::uint16_t>& distance_matrix, const std::uint32_t* a, const std::uint32_t* b,
+                  const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    reversal_deltas(distance_matrix.row(0), distance_matrix.size(), a, b, c, d, out);
+}
+
+void batch_deltas(const PackedDistanceMatrix<std::int32_t>& distance_matrix, const std::uint32_t* a,
+                  const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    packed_reversal_deltas(distance_matrix.column(0), distance_matrix.size(), a, b, c, d, out);
+}
+
+void batch_deltas(const PackedDistanceMatrix<std::uint16_t>& distance_matrix, const std::uint32_t* a,
+                  const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    packed_reversal_deltas(distance_matrix.column(0), distance_matrix.size(), a, b, c, d, out);
+}
+
+// Random segment reversals proposed DELTA_LANES at a time. A batch draws its segments together,
+// evaluates them with one reversal_deltas call and tests them in order against thresholds from
+// exponential_quantiles. Its first passing lane is the accepted move, the lanes before it are
+// rejected steps, and the lanes after it are dropped, as applying the move changes the tour they
+// were evaluated on. The chain still sees one independent proposal per step; every lane of a batch
+// is tested at the temperature of its first step.
+template <typename Distance>
+class ReversalBatch {
+public:
+    ReversalBatch(const Tour& tour, const Distance& distance_matrix, Rng& rng)
+        : tour_(tour), distance_matrix_(distance_matrix), rng_(rng) {}
+
+    // Same contract as propose_reversal.
+    std::int64_t propose(double temperature, ChainMove& move) {
+        if (lane_ == DELTA_LANES) {
+            refill(temperature);
+        }
+        const std::size_t lane = lane_++;
+        if (lane == accepted_) {
+            move = make_move(ChainMove::Reversal, starts_[lane], ends_[lane], 0, 0);
+            lane_ = DELTA_LANES;
+        }
+        return deltas_[lane];
+    }
+
+private:
+    void refill(double temperature) {
+        const std::size_t n = tour_.size();
+        for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+            const auto [start, end] = random_segment(n, rng_);
+            starts_[k] = start;
+            ends_[k] = end;
+            if (start == 0 && end + 1 == n) {
+                // Reversing the whole tour keeps every edge. These cities give its zero delta
+                // without reading the matrix diagonal.
+                a_[k] = d_[k] = tour_[0];
+                b_[k] = c_[k] = tour_[1];
+            } else {
+                a_[k] = tour_[start == 0 ? n - 1 : start - 1];
+                b_[k] = tour_[start];
+                c_[k] = tour_[end];
+                d_[k] = tour_[(end + 1) % n];
+            }
+        }
+        batch_deltas(distance_matrix_, a_, b_, c_, d_, deltas_);
+
+        const auto& quantiles = exponential_quantiles();
+        const std::uint64_t mask = (std::uint64_t{1} << THRESHOLD_BITS) - 1;
+        std::uint64_t bits = 0;
+        accepted_ = DELTA_LANES;
+        for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+            if (k % (64 / THRESHOLD_BITS) == 0) {
+                bits = rng_();
+            }
+            if (static_cast<double>(deltas_[k]) <= temperature * quantiles[bits & mask]) {
+                accepted_ = k;
+                break;
+            }
+            bits >>= THRESHOLD_BITS;
+        }
+        lane_ = 0;
+    }
+
+    const Tour& tour_;
+    const Distance& distance_matrix_;
+    Rng& rng_;
+    std::size_t lane_ = DELTA_LANES;
+    std::size_t accepted_ = DELTA_LANES;
+    std::size_t starts_[DELTA_LANES] = {};
+    std::size_t ends_[DELTA_LANES] = {};
+    std::uint32_t a_[DELTA_LANES] = {};
+    std::uint32_t b_[DELTA_LANES] = {};
+    std::uint32_t c_[DELTA_LANES] = {};
+    std::uint32_t d_[DELTA_LANES] = {};
+    std::int64_t deltas_[DELTA_LANES] = {};
+};
+
+// Proposes one move that adds the edge from a random city a to one of its candidates c: a 2-opt
+// move, or an Or-opt move that puts a segment of 1 to 3 cities ending at a next to c. Evaluation
+// is O(1), and applying it takes a short reversal or segment shift. If the Metropolis test
+// accepts the move, stores it in move and returns its length change; a rejected move leaves
+// move.kind None.
+template <typename Distance, typename TourStore>
+std::int64_t neighbor_move(const TourStore& tour, const Distance& distances, const NeighborLists& neighbors,
+                           double temperature, Rng& rng, ChainMove& move) {
+    const std::size_t n = tour.size();
+    const std::size_t a = rng.below(n);
+    const auto& candidates = neighbors[a];
+    if (candidates.empty()) {
+        return 0;
+    }
+    const std::size_t c = candidates[rng.below(candidates.size())].city;
+    auto dist = [&](std::size_t from, std::size_t to) { return std::int64_t{distances(from, to)}; };
+
+    if (rng.below(2) == 0) {
+        // Reads a b ... c d in the chosen direction; edges (a, b) and (c, d) become (a, c) and
+        // (b, d).
+        const bool forward = rng.below(2) == 0;
+        const std::size_t b = forward ? tour.next(a) : tour.prev(a);
+        const std::size_t d = forward ? tour.next(c) : tour.prev(c);
+        if (c == b || d == a) {
+            return 0;
+        }
+
+        const std::int64_t delta = dist(a, c) + dist(b, d) - dist(a, b) - dist(c, d);
+        if (!accept(delta, temperature, rng)) {
+            return 0;
+        }
+        move = make_move(ChainMove::TwoOpt, a, b, c, d);
+        return delta;
+    }
+
+    const std::size_t len = 1 + rng.below(ArrayTour::MAX_SEGMENT);
+    if (len + 3 > n) {
+        return 0;
+    }
+
+    std::size_t segment[ArrayTour::MAX_SEGMENT];
+    const bool a_first = rng.below(2) == 0;
+    segment[a_first ? 0 : len - 1] = a;
+    for (std::size_t i = 1; i < len; ++i) {
+        if (a_first) {
+            segment[i] = tour.next(segment[i - 1]);
+        } else {
+            segment[len - 1 - i] = tour.prev(segment[len - i]);
+        }
+    }
+    auto in_segment = [&](std::size_t city) { return std::find(segment, segment + len, city) != segment + len; };
+
+    const std::size_t other = rng.below(2) == 0 ? tour.next(c) : tour.prev(c);
+    if (in_segment(c) || in_segment(other)) {
+        return 0;
+    }
+
+    // Insert between after and its successor, with a next to c.
+    const std::size_t first = segment[0];
+    const std::size_t last = segment[len - 1];
+    const std::size_t after = tour.next(c) == other ? c : other;
+    const std::size_t successor = tour.next(after);
+    const bool reversed = a_first != (c == after);
+    const std::int64_t removed = dist(tour.prev(first), first) + dist(last, tour.next(last)) -
+                                 dist(tour.prev(first), tour.next(last));
+    const std::int64_t added = (reversed ? dist(after, last) + dist(first, successor)
+                                         : dist(after, first) + dist(last, successor)) - dist(after, successor);
+
+    const std::int64_t delta = added - removed;
+    if (!accept(delta, temperature, rng)) {
+        return 0;
+    }
+    move = make_move(ChainMove::OrOpt, first, last, after, successor, reversed);
+    return delta;
 }
 
 void validate(const SaParams& p) {
@@ -38,114 +338,522 @@ void validate(const SaParams& p) {
     if (!std::isfinite(p.cooling) || p.cooling <= 0.0 || p.cooling >= 1.0) {
         throw std::invalid_argument("SA cooling must be finite and between 0 and 1.");
     }
+    if (p.reheats < 0) {
+        throw std::invalid_argument("SA reheats must not be negative.");
+    }
+    if (p.replicas < 0) {
+        throw std::invalid_argument("SA replicas must not be negative.");
+    }
 }
 
 struct ChainResult {
-    std::vector<City> best_tour;
-    double best_cost = 0.0;
+    Tour best_tour;
+    std::int64_t best_cost = 0;
     bool completed = false;
+    // Cities copied to keep the best tour, and what copying it on every new best would have cost.
+    std::size_t copied_cities = 0;
+    std::size_t eager_copied_cities = 0;
 };
 
-ChainResult run_chain(const std::vector<City>& base_tour, const std::vector<double>& distance_matrix,
-                      const std::vector<std::vector<std::size_t>>& neighbors,
-                      const SaParams& params, RunController& controller) {
-    std::vector<City> current = base_tour;
-    std::shuffle(current.begin(), current.end(), gen);
+// Temperatures for a chain from the uphill moves of its starting tour, sampled without applying
+// them: the start accepts the median uphill move half the time, the end accepts the smallest
+// twentieth one time in a thousand. A reheated chain starts cooler, accepting the median uphill
+// move one time in a hundred, so it perturbs the best tour without scrambling it. Falls back to
+// the configured temperatures when the tour offers too few uphill moves to measure.
+template <typename Propose>
+std::pair<double, double> calibrate(Propose& propose, const SaParams& params, bool reheat) {
+    std::vector<std::int64_t> uphill;
+    uphill.reserve(CALIBRATION_SAMPLES);
+    for (std::size_t i = 0; i < CALIBRATION_SAMPLES; ++i) {
+        ChainMove move;
+        const std::int64_t delta = propose(std::numeric_limits<double>::infinity(), move);
+        if (move.kind != ChainMove::None && delta > 0) {
+            uphill.push_back(delta);
+        }
+    }
+    if (uphill.size() < MIN_CALIBRATION_DELTAS) {
+        return {params.start_temp, params.end_temp};
+    }
+
+    std::sort(uphill.begin(), uphill.end());
+    const double median = static_cast<double>(uphill[uphill.size() / 2]);
+    const double small = static_cast<double>(uphill[uphill.size() / 20]);
+    const double end_temp = small / std::log(1000.0);
+    const double start_temp = reheat ? median / std::log(100.0) : median / std::log(2.0);
+
+    return {std::max(start_temp, end_temp * 2.0), end_temp};
+}
+
+// A chain's current tour length and its best tour. The best tour is copied lazily: a new best
+// only marks the current tour as the best, and the copy is taken just before an accepted move
+// leaves it, or when the chain ends. A descent of k consecutive new bests then costs one copy
+// rather than k.
+class ChainState {
+public:
+    explicit ChainState(std::int64_t cost) : cost_(cost) { result_.best_cost = cost; }
+
+    std::int64_t cost() const { return cost_; }
+
+    // One proposal at temperature. propose(temperature, move) runs the Metropolis test, recording
+    // an accepted move in move and returning its change in tour length; apply(move) performs it
+    // and save(tour) copies the current tour out.
+    template <typename Propose, typename Apply, typename Save>
+    void step(double temperature, Propose& propose, Apply& apply, Save& save) {
+        ChainMove move;
+        const std::int64_t delta = propose(temperature, move);
+        if (move.kind == ChainMove::None) {
+            return;
+        }
+        // A move of zero length change keeps a tour as short as the best, so it may replace it.
+        if (best_is_current_ && delta > 0) {
+            save(result_.best_tour);
+            ++copies_;
+            best_is_current_ = false;
+        }
+        apply(move);
+        cost_ += delta;
+        if (cost_ < result_.best_cost) {
+            result_.best_cost = cost_;
+            best_is_current_ = true;
+            ++improvements_;
+        }
+    }
+
+    template <typename Save>
+    ChainResult finish(std::size_t n, bool completed, Save& save) {
+        if (best_is_current_) {
+            save(result_.best_tour);
+            ++copies_;
+        }
+        result_.completed = completed;
+        result_.copied_cities = copies_ * n;
+        result_.eager_copied_cities = (1 + improvements_) * n;
+        return std::move(result_);
+    }
+
+private:
+    std::int64_t cost_;
+    ChainResult result_;
+    bool best_is_current_ = true;
+    std::size_t copies_ = 0;
+    std::size_t improvements_ = 0;
+};
 
-    double current_cost = total_cost_unchecked(current, distance_matrix);
-    std::vector<City> best = current;
-    double best_cost = current_cost;
-    double temperature = params.start_temp;
+// Cools from the start to the end temperature with one proposal per step (see ChainState::step).
+//
+// The fixed schedule cools geometrically from the configured temperatures. The adaptive one
+// calibrates them from the starting tour and, given a deadline on the controller's clock, runs
+// until it: every time check re-derives the cooling factor that reaches the end temperature just
+// as the deadline passes, at the moves per second measured so far.
+template <typename Propose, typename Apply, typename Save>
+ChainResult anneal(std::size_t n, std::int64_t current_cost, const SaParams& params, RunController& controller,
+                   bool reheat, double deadline, Propose&& propose, Apply&& apply, Save&& save) {
+    ChainState chain(current_cost);
     std::size_t steps_since_time_check = 0;
 
-    while (temperature > params.end_temp) {
-        if (steps_since_time_check == 0 && controller.time_expired()) {
-            return {best, total_cost_unchecked(best, distance_matrix), false};
-        }
-
-        const auto [start, end] = random_segment(current.size());
-        const double delta = tour_reversal_delta(current, distance_matrix, start, end);
-        const bool accepted = delta < 0.0 || accept_worse(std::exp(-delta / temperature));
-        if (accepted) {
-            std::reverse(current.begin() + static_cast<std::ptrdiff_t>(start),
-                         current.begin() + static_cast<std::ptrdiff_t>(end + 1));
-            current_cost += delta;
-            if (current_cost < best_cost) {
-                best_cost = current_cost;
-                best = current;
+    double start_temp = params.start_temp;
+    double end_temp = params.end_temp;
+    double cooling = params.cooling;
+    const bool adaptive = params.schedule == SaSchedule::Adaptive;
+    const bool until_deadline = adaptive && std::isfinite(deadline);
+    if (adaptive) {
+        std::tie(start_temp, end_temp) = calibrate(propose, params, reheat);
+    }
+    if (until_deadline) {
+        // Held until the first time check has measured a rate.
+        cooling = 1.0;
+    }
+    double temperature = start_temp;
+    const double chain_start = until_deadline ? controller.elapsed() : 0.0;
+    std::size_t steps = 0;
+
+    while (until_deadline || temperature > end_temp) {
+        if (steps_since_time_check == 0) {
+            if (controller.time_expired()) {
+                return chain.finish(n, false, save);
+            }
+            if (until_deadline) {
+                const double now = controller.elapsed();
+                if (now >= deadline) {
+                    break;
+                }
+                if (steps > 0 && now > chain_start) {
+                    const double steps_left = static_cast<double>(steps) / (now - chain_start) * (deadline - now);
+                    cooling = std::pow(end_temp / temperature, 1.0 / std::max(1.0, steps_left));
+                }
             }
         }
 
-        temperature = std::max(temperature * params.cooling, params.end_temp);
+        chain.step(temperature, propose, apply, save);
+
+        temperature = std::max(temperature * cooling, end_temp);
         steps_since_time_check = (steps_since_time_check + 1) % TIME_CHECK_INTERVAL;
+        ++steps;
     }
 
-    if (params.two_opt && !controller.time_expired()) {
-        two_opt_neighbors_unchecked(best, distance_matrix, neighbors, TWO_OPT_MOVES, &controller);
+    return chain.finish(n, true, save);
+}
+
+// Holds each of count threads until all have arrived, runs completion on the last to arrive, then
+// releases them together.
+class RoundBarrier {
+public:
+    RoundBarrier(std::size_t count, std::function<void()> completion)
+        : count_(count), completion_(std::move(completion)) {}
+
+    void arrive_and_wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const std::size_t generation = generation_;
+        if (++arrived_ == count_) {
+            release(lock);
+            return;
+        }
+        released_.wait(lock, [&] { return generation_ != generation; });
     }
 
-    return {best, total_cost_unchecked(best, distance_matrix), true};
-}
+    // Leaves for good, as a thread that will not arrive again; the round ends if everyone left
+    // was already waiting.
+    void arrive_and_drop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (--count_ > 0 && arrived_ == count_) {
+            release(lock);
+        }
+    }
 
-}
+private:
+    void release(std::unique_lock<std::mutex>& lock) {
+        completion_();
+        arrived_ = 0;
+        ++generation_;
+        lock.unlock();
+        released_.notify_all();
+    }
 
-double tour_reversal_delta(const std::vector<City>& cities, const std::vector<double>& distance_matrix, std::size_t start, std::size_t end) {
-    const std::size_t n = cities.size();
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::size_t count_;
+    std::size_t arrived_ = 0;
+    std::size_t generation_ = 0;
+    std::function<void()> completion_;
+};
 
-    if (n < 2) {
-        throw std::invalid_argument("Reversal delta requires at least two cities.");
+// Parallel tempering: one replica per thread, each a Metropolis chain at its own rung of a
+// temperature ladder whose hottest rung is LADDER_SPREAD times the coldest. Replicas run rounds
+// of SWAP_INTERVAL steps and meet at a barrier between them. There, adjacent rungs swap replicas
+// by the Metropolis exchange test, so a good tour found hot can sink to the cold end, and the
+// ladder cools as a single chain's temperature would. Replicas trade rungs, never tours, and
+// each has its own Rng, so a run under the fixed schedule does not depend on thread timing.
+class Tempering {
+public:
+    Tempering(std::size_t replicas, const SaParams& params, const RunController& controller, double deadline,
+              Rng& rng)
+        : params_(params), controller_(controller), rng_(rng), deadline_(deadline),
+          until_deadline_(params.schedule == SaSchedule::Adaptive && std::isfinite(deadline)),
+          start_temp_(params.start_temp), end_temp_(params.end_temp), ladder_(replicas), replica_at_(replicas),
+          rung_of_(replicas), costs_(replicas), barrier_(replicas, [this] { end_round(); }) {
+        for (std::size_t i = 0; i < replicas; ++i) {
+            replica_at_[i] = i;
+            rung_of_[i] = i;
+        }
     }
-    if (distance_matrix.size() != n * n) {
-        throw std::invalid_argument("Distance matrix size does not match tour size.");
+
+    // Runs replica index of n cities, starting at cost, until the ladder has cooled, its deadline
+    // has passed or time runs out; the arguments after reheat are anneal's. Every replica must
+    // call this, each on its own thread.
+    template <typename Propose, typename Apply, typename Save>
+    ChainResult run_replica(std::size_t index, std::size_t n, std::int64_t cost, bool reheat, Propose&& propose,
+                            Apply&& apply, Save&& save) {
+        ChainState chain(cost);
+        if (index == 0 && params_.schedule == SaSchedule::Adaptive) {
+            std::tie(start_temp_, end_temp_) = calibrate(propose, params_, reheat);
+        }
+        costs_[index] = cost;
+        barrier_.arrive_and_wait();
+
+        while (!stop_) {
+            const double temperature = ladder_[rung_of_[index]];
+            for (std::size_t step = 0; step < SWAP_INTERVAL; ++step) {
+                chain.step(temperature, propose, apply, save);
+            }
+            costs_[index] = chain.cost();
+            barrier_.arrive_and_wait();
+        }
+
+        return chain.finish(n, completed_, save);
     }
-    if (start >= n || end >= n || start > end) {
-        throw std::invalid_argument("Reversal delta segment is out of range.");
+
+    // Called once for a replica that failed and will not arrive again: the others finish the round
+    // and stop, so nothing waits for it.
+    void abandon() {
+        failed_ = true;
+        barrier_.arrive_and_drop();
     }
-    if (start == 0 && end + 1 == n) {
-        return 0.0;
+
+private:
+    // The barrier's completion: exchanges, cools and decides whether to stop. The first call, once
+    // the replicas are set up, only lays out the ladder.
+    void end_round() {
+        const std::size_t replicas = ladder_.size();
+
+        if (rounds_ == 0) {
+            base_ = start_temp_;
+            cooling_ = until_deadline_ ? 1.0 : std::pow(params_.cooling, static_cast<double>(SWAP_INTERVAL));
+            chain_start_ = controller_.elapsed();
+        } else {
+            // Even and odd pairs of rungs take turns.
+            for (std::size_t rung = rounds_ % 2; rung + 1 < replicas; rung += 2) {
+                const std::size_t cold = replica_at_[rung];
+                const std::size_t hot = replica_at_[rung + 1];
+                const double exponent = (1.0 / ladder_[rung] - 1.0 / ladder_[rung + 1]) *
+                                        static_cast<double>(costs_[cold] - costs_[hot]);
+                if (exponent >= 0.0 || accept_worse(std::exp(exponent), rng_)) {
+                    std::swap(replica_at_[rung], replica_at_[rung + 1]);
+                    rung_of_[cold] = rung + 1;
+                    rung_of_[hot] = rung;
+                }
+            }
+
+            if (until_deadline_) {
+                const double now = controller_.elapsed();
+                if (now >= deadline_) {
+                    stop_ = true;
+                    completed_ = true;
+                } else if (now > chain_start_) {
+                    const double rounds_left = static_cast<double>(rounds_) / (now - chain_start_) * (deadline_ - now);
+                    cooling_ = std::pow(end_temp_ / base_, 1.0 / std::max(1.0, rounds_left));
+                }
+            }
+            base_ = std::max(base_ * cooling_, end_temp_);
+            if (!until_deadline_ && base_ <= end_temp_) {
+                stop_ = true;
+                completed_ = true;
+            }
+        }
+        if (!stop_ && (failed_ || controller_.time_expired())) {
+            stop_ = true;
+            completed_ = false;
+        }
+
+        for (std::size_t rung = 0; rung < replicas; ++rung) {
+            const double height = replicas > 1 ? static_cast<double>(rung) / static_cast<double>(replicas - 1) : 0.0;
+            ladder_[rung] = base_ * std::pow(LADDER_SPREAD, height);
+        }
+        ++rounds_;
     }
 
-    const std::size_t before_start = start == 0 ? n - 1 : start - 1;
-    const std::size_t after_end = (end + 1) % n;
+    const SaParams& params_;
+    const RunController& controller_;
+    Rng& rng_;
+    const double deadline_;
+    const bool until_deadline_;
+
+    // Written by replica 0 before the first round, read by end_round.
+    double start_temp_;
+    double end_temp_;
+
+    // Written only by end_round, while every replica waits at the barrier.
+    std::vector<double> ladder_;
+    std::vector<std::size_t> replica_at_;
+    std::vector<std::size_t> rung_of_;
+    double base_ = 0.0;
+    double cooling_ = 1.0;
+    double chain_start_ = 0.0;
+    std::size_t rounds_ = 0;
+    bool stop_ = false;
+    bool completed_ = false;
+
+    // Set by abandon, from whichever thread failed.
+    std::atomic<bool> failed_{false};
+
+    // Each replica's current tour length, written by that replica before it arrives.
+    std::vector<std::int64_t> costs_;
+    RoundBarrier barrier_;
+};
 
-    const auto a = static_cast<std::size_t>(cities[before_start].id - 1);
-    const auto b = static_cast<std::size_t>(cities[start].id - 1);
-    const auto c = static_cast<std::size_t>(cities[end].id - 1);
-    const auto d = static_cast<std::size_t>(cities[after_end].id - 1);
+// Runs run_replica(i) for every replica, the calling thread taking replica 0, and keeps the best
+// tour any of them found. A replica that throws, or whose thread cannot start, abandons the
+// tempering; the others stop at the next barrier and the first failure is rethrown once all joined.
+template <typename RunReplica>
+ChainResult temper(Tempering& tempering, std::size_t replicas, RunReplica&& run_replica) {
+    std::vector<ChainResult> results(replicas);
+    std::vector<std::exception_ptr> failures(replicas);
+    const auto run = [&](std::size_t i) {
+        try {
+            results[i] = run_replica(i);
+        }
+        catch (...) {
+            failures[i] = std::current_exception();
+            tempering.abandon();
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    helpers.reserve(replicas - 1);
+    for (std::size_t i = 1; i < replicas; ++i) {
+        try {
+            helpers.emplace_back(run, i);
+        }
+        catch (...) {
+            failures[i] = std::current_exception();
+            tempering.abandon();
+        }
+    }
+    run(0);
+    for (auto& helper: helpers) {
+        helper.join();
+    }
+    for (const auto& failure: failures) {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
 
-    const double old_cost = distance_matrix[a * n + b] + distance_matrix[c * n + d];
-    const double new_cost = distance_matrix[a * n + c] + distance_matrix[b * n + d];
+    std::size_t best = 0;
+    std::size_t copied_cities = 0;
+    std::size_t eager_copied_cities = 0;
+    for (std::size_t i = 0; i < replicas; ++i) {
+        if (results[i].best_cost < results[best].best_cost) {
+            best = i;
+        }
+        copied_cities += results[i].copied_cities;
+        eager_copied_cities += results[i].eager_copied_cities;
+    }
 
-    return new_cost - old_cost;
+    ChainResult chain = std::move(results[best]);
+    chain.copied_cities = copied_cities;
+    chain.eager_copied_cities = eager_copied_cities;
+    return chain;
 }
 
-SolveResult sa_solve(std::vector<City>& cities, const SaParams& params, const StopCondition& stop) {
-    validate_tour_input(cities, "Simulated annealing");
-    validate(params);
+// Anneals from a shuffle of base_tour, or from base_tour itself when reheating it: one chain, or
+// one parallel-tempering replica per workspace when there are several.
+template <typename Distance>
+ChainResult run_chain(const Tour& base_tour, const Distance& distance_matrix,
+                      const NeighborLists& neighbors,
+                      const SaParams& params, RunController& controller, Rng& rng,
+                      std::vector<LocalSearchWorkspace>& workspaces, bool reheat, double deadline) {
+    const std::size_t n = base_tour.size();
+    const std::size_t replicas = workspaces.size();
+    std::vector<Tour> starts(replicas, base_tour);
+    std::vector<std::int64_t> costs;
+    costs.reserve(replicas);
+    for (auto& start: starts) {
+        if (!reheat) {
+            shuffle_range(start.begin(), start.end(), rng);
+        }
+        costs.push_back(total_cost_unchecked(start, distance_matrix));
+    }
 
-    RunController controller(stop);
-    controller.start();
+    // Replicas draw from their own streams; a single chain keeps the run's.
+    std::vector<Rng> rngs;
+    if (replicas > 1) {
+        rngs.reserve(replicas);
+        for (std::size_t i = 0; i < replicas; ++i) {
+            rngs.emplace_back(rng());
+        }
+    }
 
-    const std::vector<double> distance_matrix = build_distance_matrix(cities);
-    const std::vector<City> base_tour = cities;
-    const std::vector<std::vector<std::size_t>> neighbors =
-        params.two_opt ? build_neighbor_lists(distance_matrix, cities.size(), TWO_OPT_NEIGHBORS)
-                       : std::vector<std::vector<std::size_t>>{};
+    // Large tours use the two-level list, so an accepted move costs O(sqrt(n)) instead of a
+    // reversal of up to n/2 cities while the chain is still hot and the tour random. The stores
+    // are set up here, so replica threads only read and move their own.
+    const bool neighbor_moves = params.moves == SaMoves::Neighbor && n >= 4;
+    const bool two_level = neighbor_moves && choose_tour_store(n, tour_store_setting()) == TourStore::TwoLevel;
+    std::vector<ArrayTour> arrays;
+    if (neighbor_moves) {
+        arrays.reserve(two_level ? 0 : replicas);
+        for (std::size_t i = 0; i < replicas; ++i) {
+            if (two_level) {
+                workspaces[i].two_level.assign(starts[i]);
+            } else {
+                arrays.emplace_back(starts[i], workspaces[i].positions);
+            }
+        }
+    }
+
+    // Calls run(propose, apply, save) with replica i's moves.
+    auto with_moves = [&](std::size_t i, auto&& run) -> ChainResult {
+        Rng& chain_rng = rngs.empty() ? rng : rngs[i];
+        auto neighbor_moves_on = [&](auto& tour) {
+            return run(
+                [&](double temperature, ChainMove& move) {
+                    return neighbor_move(tour, distance_matrix, neighbors, temperature, chain_rng, move);
+                },
+                [&](const ChainMove& move) { apply_move(tour, move); }, [&](Tour& copy) { tour.write(copy); });
+        };
+
+        if (neighbor_moves) {
+            return two_level ? neighbor_moves_on(workspaces[i].two_level) : neighbor_moves_on(arrays[i]);
+        }
 
-    std::vector<City> global_best = cities;
+        Tour& current = starts[i];
+        ReversalBatch<Distance> batch(current, distance_matrix, chain_rng);
+        return run([&](double temperature, ChainMove& move) { return batch.propose(temperature, move); },
+                   [&](const ChainMove& move) { apply_reversal(current, move); }, [&](Tour& copy) { copy = current; });
+    };
+
+    ChainResult chain;
+    if (replicas > 1) {
+        Tempering tempering(replicas, params, controller, deadline, rng);
+        chain = temper(tempering, replicas, [&](std::size_t i) {
+            return with_moves(i, [&](auto&& propose, auto&& apply, auto&& save) {
+                return tempering.run_replica(i, n, costs[i], reheat, propose, apply, save);
+            });
+        });
+    } else {
+        chain = with_moves(0, [&](auto&& propose, auto&& apply, auto&& save) {
+            return anneal(n, costs[0], params, controller, reheat, deadline, propose, apply, save);
+        });
+    }
 
-    double global_best_cost = total_cost_unchecked(global_best, distance_matrix);
+    if (chain.completed && params.two_opt && !controller.time_expired()) {
+        local_search_unchecked(chain.best_tour, distance_matrix, neighbors, params.local_search, TWO_OPT_MOVES,
+                               &controller, &workspaces.front());
+    }
+    chain.best_cost = total_cost_unchecked(chain.best_tour, distance_matrix);
+
+    return chain;
+}
+
+template <typename Distance>
+SolveResult solve_with(std::vector<City>& cities, const std::vector<City>& city_by_index,
+                       const Distance& distance_matrix, const NeighborLists& neighbors, const SaParams& params,
+                       const StopCondition& stop, RunController& controller, SolverContext& context) {
+    const Tour base_tour = to_tour(cities);
+
+    Tour global_best = base_tour;
+
+    std::int64_t global_best_cost = total_cost_unchecked(global_best, distance_matrix);
 
     std::size_t attempted_restarts = 0;
     std::size_t completed_restarts = 0;
     StopReason stop_reason = StopReason::None;
 
     const bool timed_mode = std::isfinite(stop.max_seconds);
+    std::vector<LocalSearchWorkspace> workspaces(replica_count(params));
+    std::size_t copied_cities = 0;
+    std::size_t eager_copied_cities = 0;
+
+    const auto reheats = static_cast<std::size_t>(params.reheats);
+    const bool planned_time = timed_mode && params.schedule == SaSchedule::Adaptive;
 
     while ((timed_mode && attempted_restarts == 0) || controller.next(global_best_cost)) {
         ++attempted_restarts;
 
-        ChainResult chain = run_chain(base_tour, distance_matrix, neighbors, params, controller);
+        // An adaptive timed run plans the first chain and its reheats to share the time left. Chains
+        // after the planned ones get the remainder, which is too short to cool a fresh shuffle, so
+        // they reheat the best tour as well.
+        double deadline = std::numeric_limits<double>::infinity();
+        if (planned_time) {
+            const double now = controller.elapsed();
+            const std::size_t chains_left = completed_restarts <= reheats ? 1 + reheats - completed_restarts : 1;
+            deadline = now + (stop.max_seconds - now) * TIME_BUDGET_SHARE / static_cast<double>(chains_left);
+        }
+        const bool reheat = completed_restarts > 0 && (completed_restarts <= reheats || planned_time);
+
+        ChainResult chain = run_chain(reheat ? global_best : base_tour, distance_matrix, neighbors, params,
+                                      controller, context.rng, workspaces, reheat, deadline);
+        copied_cities += chain.copied_cities;
+        eager_copied_cities += chain.eager_copied_cities;
 
         if (!chain.completed) {
             stop_reason = StopReason::TimeLimit;
@@ -169,7 +877,134 @@ SolveResult sa_solve(std::vector<City>& cities, const SaParams& params, const St
     }
 
     global_best_cost = total_cost_unchecked(global_best, distance_matrix);
-    cities = global_best;
+    cities = to_cities(global_best, city_by_index);
+
+    SolveResult result{static_cast<double>(global_best_cost), attempted_restarts, controller.converged(), stop_reason,
+                       completed_restarts};
+    result.saved_copy_cities = eager_copied_cities > copied_cities ? eager_copied_cities - copied_cities : 0;
+    return result;
+}
+
+SolveResult solve_prepared(std::vector<City>& cities, const PreparedInstance& instance, const SaParams& params,
+                           const StopCondition& stop, RunController& controller, SolverContext& context) {
+    static const NeighborLists no_neighbors;
+    const NeighborLists& neighbors = uses_neighbors(params) ? instance.candidates(params.candidates, TWO_OPT_NEIGHBORS)
+                                                            : no_neighbors;
+
+    return instance.visit([&](const auto& distance_matrix) {
+        return solve_with(cities, instance.cities(), distance_matrix, neighbors, params, stop, controller, context);
+    });
+}
+
+}
+
+template <typename Distance>
+std::int64_t tour_reversal_delta(const Tour& tour, const Distance& distance_matrix, std::size_t start, std::size_t end) {
+    const std::size_t n = tour.size();
+
+    if (n < 2) {
+        throw std::invalid_argument("Reversal delta requires at least two cities.");
+    }
+    if (distance_matrix.size() != n) {
+        throw std::invalid_argument("Distance matrix size does not match tour size.");
+    }
+    if (start >= n || end >= n || start > end) {
+        throw std::invalid_argument("Reversal delta segment is out of range.");
+    }
+    if (start == 0 && end + 1 == n) {
+        return 0;
+    }
+
+    const std::size_t before_start = start == 0 ? n - 1 : start - 1;
+    const std::size_t after_end = (end + 1) % n;
+
+    const std::size_t a = tour[before_start];
+    const std::size_t b = tour[start];
+    const std::size_t c = tour[end];
+    const std::size_t d = tour[after_end];
+
+    const std::int64_t old_cost = std::int64_t{distance_matrix(a, b)} + distance_matrix(c, d);
+    const std::int64_t new_cost = std::int64_t{distance_matrix(a, c)} + distance_matrix(b, d);
+
+    return new_cost - old_cost;
+}
+
+template std::int64_t tour_reversal_delta(const Tour&, const DistanceMatrix<std::uint16_t>&,
+                                          std::size_t, std::size_t);
+template std::int64_t tour_reversal_delta(const Tour&, const DistanceMatrix<std::int32_t>&,
+                                          std::size_t, std::size_t);
+template std::int64_t tour_reversal_delta(const Tour&, const PackedDistanceMatrix<std::uint16_t>&,
+                                          std::size_t, std::size_t);
+template std::int64_t tour_reversal_delta(const Tour&, const PackedDistanceMatrix<std::int32_t>&,
+                                          std::size_t, std::size_t);
+template std::int64_t tour_reversal_delta(const Tour&, const CoordinateDistance&,
+                                          std::size_t, std::size_t);
+
+template <typename Distance>
+std::int64_t sa_reversal_steps(Tour& tour, const Distance& distance_matrix, double temperature, std::size_t steps,
+                               bool batched, Rng& rng) {
+    if (tour.size() < 2 || distance_matrix.size() != tour.size()) {
+        throw std::invalid_argument("Reversal steps need at least two cities and a matching distance matrix.");
+    }
+
+    std::int64_t change = 0;
+    auto run = [&](auto&& propose) {
+        for (std::size_t step = 0; step < steps; ++step) {
+            ChainMove move;
+            const std::int64_t delta = propose(temperature, move);
+            if (move.kind != ChainMove::None) {
+                apply_reversal(tour, move);
+                change += delta;
+            }
+        }
+    };
+
+    if (batched) {
+        ReversalBatch<Distance> batch(tour, distance_matrix, rng);
+        run([&](double t, ChainMove& move) { return batch.propose(t, move); });
+    } else {
+        run([&](double t, ChainMove& move) { return propose_reversal(tour, distance_matrix, t, rng, move); });
+    }
+
+    return change;
+}
+
+template std::int64_t sa_reversal_steps(Tour&, const DistanceMatrix<std::uint16_t>&, double, std::size_t, bool, Rng&);
+template std::int64_t sa_reversal_steps(Tour&, const DistanceMatrix<std::int32_t>&, double, std::size_t, bool, Rng&);
+template std::int64_t sa_reversal_steps(Tour&, const PackedDistanceMatrix<std::uint16_t>&, double, std::size_t, bool,
+                                        Rng&);
+template std::int64_t sa_reversal_steps(Tour&, const PackedDistanceMatrix<std::int32_t>&, double, std::size_t, bool,
+                                        Rng&);
+template std::int64_t sa_reversal_steps(Tour&, const CoordinateDistance&, double, std::size_t, bool, Rng&);
+
+InstanceRequirements sa_requirements(const SaParams& params) {
+    InstanceRequirements requirements;
+    if (uses_neighbors(params)) {
+        requirements.candidates.push_back({params.candidates, TWO_OPT_NEIGHBORS});
+    }
+
+    return requirements;
+}
+
+SolveResult sa_solve(std::vector<City>& cities, const SaParams& params, const StopCondition& stop,
+                     SolverContext& context) {
+    validate_tour_input(cities, "Simulated annealing");
+    validate(params);
+
+    RunController controller(stop);
+    controller.start();
+
+    const PreparedInstance instance(cities, sa_requirements(params));
+    return solve_prepared(cities, instance, params, stop, controller, context);
+}
+
+SolveResult sa_solve(std::vector<City>& cities, const PreparedInstance& instance, const SaParams& params,
+                     const StopCondition& stop, SolverContext& context) {
+    instance.validate_tour(cities, "Simulated annealing");
+    validate(params);
+
+    RunController controller(stop);
+    controller.start();
 
-    return {global_best_cost, attempted_restarts, controller.converged(), stop_reason, completed_restarts};
+    return solve_prepared(cities, instance, params, stop, controller, context);
 }
@@ -2,14 +2,33 @@
 #define TSP_ALGORITHMS_SA
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "../core/config.hpp"
+#include "../core/prepared_instance.hpp"
 #include "../core/tsp.hpp"
 
-double tour_reversal_delta(const std::vector<City>& cities, const std::vector<double>& distance_matrix,
-                           std::size_t start, std::size_t end);
+template <typename Distance>
+std::int64_t tour_reversal_delta(const Tour& tour, const Distance& distances,
+                                 std::size_t start, std::size_t end);
 
-SolveResult sa_solve(std::vector<City>& cities, const SaParams& params, const StopCondition& stop);
+// Runs steps Metropolis steps of random segment reversals on tour at a fixed temperature and
+// returns the change in its length. batched proposes them eight at a time, as a segment-move chain
+// does, with gathered deltas and tabulated thresholds; otherwise each step evaluates one reversal
+// and calls exp. tsp_microbench times both.
+template <typename Distance>
+std::int64_t sa_reversal_steps(Tour& tour, const Distance& distances, double temperature, std::size_t steps,
+                               bool batched, Rng& rng);
+
+// Candidate lists sa_solve reads from a PreparedInstance.
+InstanceRequirements sa_requirements(const SaParams& params);
+
+// Prepares distances and lists itself, inside the run's time budget.
+SolveResult sa_solve(std::vector<City>& cities, const SaParams& params, const StopCondition& stop,
+                     SolverContext& context);
+// Starts from cities, a tour over instance's cities; preparation is not charged to the budget.
+SolveResult sa_solve(std::vector<City>& cities, const PreparedInstance& instance, const SaParams& params,
+                     const StopCondition& stop, SolverContext& context);
 
 #endif
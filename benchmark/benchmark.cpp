@@ -1,22 +1,34 @@
 #include "benchmark.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <exception>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include "../algorithms/aco.hpp"
 #include "../algorithms/genetic.hpp"
 #include "../algorithms/sa.hpp"
 #include "../core/config.hpp"
 #include "../core/datasets.hpp"
+#include "../core/instance_cache.hpp"
+#include "../core/prepared_instance.hpp"
 #include "../core/tsp.hpp"
 
 namespace {
@@ -30,7 +42,8 @@ struct AlgorithmRunner {
     std::uint32_t id;
     std::string params_text;
     std::string unit;
-    std::function<SolveResult(std::vector<City>&, const StopCondition&)> solve;
+    InstanceRequirements requirements;
+    std::function<SolveResult(std::vector<City>&, const PreparedInstance&, const StopCondition&, SolverContext&)> solve;
 };
 
 ConfigMap load_params(const std::string& algorithm, const BenchmarkConfig& config) {
@@ -53,9 +66,33 @@ std::vector<AlgorithmRunner> build_runners(const BenchmarkConfig& config) {
         if (config.two_opt_override.has_value()) {
             p.two_opt = *config.two_opt_override;
         }
+        if (config.candidates_override.has_value()) {
+            p.candidates = *config.candidates_override;
+        }
+        if (config.local_search_override.has_value()) {
+            p.local_search = *config.local_search_override;
+        }
+
+        // Replica threads inherit their worker's affinity, so a pinned worker has one core for
+        // all of them; unpinned, the workers share the hardware threads.
+        if (config.pin_threads && p.replicas > 1) {
+            throw std::invalid_argument("--pin-threads requires SA replicas = 1: replica threads would share "
+                                        "their worker's core");
+        }
+        // Only replicas = 0 is resolved against the machine: a configured count is kept, so --jobs
+        // and the host never change the tours.
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        if (p.replicas == 0) {
+            p.replicas = config.pin_threads ? 1 : std::max(1, cores / config.jobs);
+        } else if (static_cast<long long>(p.replicas) * config.jobs > cores) {
+            std::cout << "[SA] warning: replicas=" << p.replicas << " with --jobs " << config.jobs << " runs "
+                      << static_cast<long long>(p.replicas) * config.jobs << " threads on " << cores
+                      << " hardware threads; timed runs will share cores\n";
+        }
 
-        runners.push_back({"SA", SA_ID, describe(p), "restart_attempt",
-                           [p](std::vector<City>& c, const StopCondition& s) { return sa_solve(c, p, s); }});
+        runners.push_back({"SA", SA_ID, describe(p), "restart_attempt", sa_requirements(p),
+                           [p](std::vector<City>& c, const PreparedInstance& i, const StopCondition& s,
+                               SolverContext& x) { return sa_solve(c, i, p, s, x); }});
     }
     if (all || config.algorithm == "ga") {
         GaParams p = ga_params_from(load_params("ga", config));
@@ -63,9 +100,16 @@ std::vector<AlgorithmRunner> build_runners(const BenchmarkConfig& config) {
         if (config.two_opt_override.has_value()) {
             p.two_opt = *config.two_opt_override;
         }
+        if (config.candidates_override.has_value()) {
+            p.candidates = *config.candidates_override;
+        }
+        if (config.local_search_override.has_value()) {
+            p.local_search = *config.local_search_override;
+        }
 
-        runners.push_back({"GA", GA_ID, describe(p), "generation",
-                           [p](std::vector<City>& c, const StopCondition& s) { return ga_solve(c, p, s); }});
+        runners.push_back({"GA", GA_ID, describe(p), "generation", ga_requirements(p),
+                           [p](std::vector<City>& c, const PreparedInstance& i, const StopCondition& s,
+                               SolverContext& x) { return ga_solve(c, i, p, s, x); }});
     }
     if (all || config.algorithm == "aco") {
         AcoParams p = aco_params_from(load_params("aco", config));
@@ -73,9 +117,16 @@ std::vector<AlgorithmRunner> build_runners(const BenchmarkConfig& config) {
         if (config.two_opt_override.has_value()) {
             p.two_opt = *config.two_opt_override;
         }
+        if (config.candidates_override.has_value()) {
+            p.candidates = *config.candidates_override;
+        }
+        if (config.local_search_override.has_value()) {
+            p.local_search = *config.local_search_override;
+        }
 
-        runners.push_back({"ACO", ACO_ID, describe(p), "epoch",
-                           [p](std::vector<City>& c, const StopCondition& s) { return aco_solve(c, p, s); }});
+        runners.push_back({"ACO", ACO_ID, describe(p), "epoch", aco_requirements(p),
+                           [p](std::vector<City>& c, const PreparedInstance& i, const StopCondition& s,
+                               SolverContext& x) { return aco_solve(c, i, p, s, x); }});
     }
 
     if (runners.empty()) {
@@ -206,12 +257,144 @@ std::size_t sa_progress_interval(const std::string& group) {
     return 50;
 }
 
+
+// Result of one solve, filled in by whichever worker ran it.
+struct RunOutcome {
+    std::size_t n = 0;
+    double cost = 0.0;
+    double seconds = 0.0;
+    SolveResult result;
+};
+
+// The repeats of one runner on one dataset, which make up one CSV row.
+struct RunGroup {
+    std::size_t dataset_index;
+    const AlgorithmRunner* runner;
+    std::vector<RunOutcome> runs;
+    std::size_t remaining;
+};
+
+// A dataset loaded through its .tspb cache and prepared once, when the first of its runs is
+// claimed, outside every run's budget. Runs start from their own copy of the cities and share
+// distances and candidate lists read-only; both are freed once the dataset's last group is
+// reported, so only the datasets in flight hold memory.
+struct PreparedDataset {
+    std::mutex mutex;
+    std::unique_ptr<InstanceCache> cache;
+    std::unique_ptr<PreparedInstance> instance;
+    double load_seconds = 0.0;
+    double preprocess_seconds = 0.0;
+};
+
+// Binds the calling thread to the worker_index-th CPU it may run on (wrapping around), so timed
+// runs do not migrate or share a core. A no-op where affinity is unavailable.
+void pin_current_thread(std::size_t worker_index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return;
+    }
+
+    std::size_t target = worker_index % static_cast<std::size_t>(CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        if (target-- == 0) {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(cpu, &pinned);
+            pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+            return;
+        }
+    }
+#else
+    (void)worker_index;
+#endif
+}
+
+void report_group(std::ostream& out, std::ostream& log, const BenchmarkConfig& config, const Dataset& dataset,
+                  double load_seconds, double preprocess_seconds, const RunGroup& group) {
+    const AlgorithmRunner& runner = *group.runner;
+    const double best_known = best_known_for(dataset.name);
+    std::vector<double> costs;
+    std::vector<double> times;
+    std::vector<double> units;
+    std::vector<double> fallbacks;
+    std::vector<double> saved_copies;
+    int stable_runs = 0;
+    int time_limit_runs = 0;
+    int iteration_limit_runs = 0;
+
+    for (const RunOutcome& run: group.runs) {
+        costs.push_back(run.cost);
+        times.push_back(run.seconds);
+        units.push_back(static_cast<double>(run.result.iterations));
+        fallbacks.push_back(static_cast<double>(run.result.fallbacks));
+        saved_copies.push_back(static_cast<double>(run.result.saved_copy_cities));
+        stable_runs += run.result.stop_reason == StopReason::Stable ? 1 : 0;
+        time_limit_runs += run.result.stop_reason == StopReason::TimeLimit ? 1 : 0;
+        iteration_limit_runs += run.result.stop_reason == StopReason::IterationLimit ? 1 : 0;
+    }
+
+    const std::size_t n = group.runs.front().n;
+
+    const double best_cost = *std::min_element(costs.begin(), costs.end());
+    const double mean_cost = mean(costs);
+    const double best_gap = gap_percent(best_cost, best_known);
+    const double mean_gap = gap_percent(mean_cost, best_known);
+
+    out << runner.name << "," << dataset.size_class << "," << dataset.name << "," << n << ","
+        << config.seed << "," << config.repeats << "," << runner.params_text << "," << runner.unit << ","
+        << best_cost << "," << mean_cost << "," << stddev(costs, mean_cost) << ",";
+    if (best_known > 0.0) {
+        out << best_known << "," << best_gap << "," << mean_gap;
+    } else {
+        out << ",,";
+    }
+    out << "," << mean(times) << "," << mean(units) << ","
+        << stable_runs << "," << time_limit_runs << "," << iteration_limit_runs << ","
+        << mean(fallbacks) << "," << preprocess_seconds << "," << mean(saved_copies) << ","
+        << load_seconds << "\n";
+
+    log << "  [" << runner.name << "] " << dataset.name << " (n=" << n << ") best=" << best_cost
+        << " mean=" << mean_cost << " best_gap=";
+    if (best_known > 0.0) {
+        log << best_gap << "%";
+    }
+    else {
+        log << "n/a";
+    }
+
+    log << " time=" << mean(times) << "s";
+
+    if (runner.name == "SA") {
+        log << " restart_attempts=" << mean(units) << " saved_copy_cities=" << mean(saved_copies);
+    }
+    if (runner.name == "ACO") {
+        log << " fallbacks=" << mean(fallbacks);
+    }
+    if (config.benchmark_mode == "stable") {
+        if (runner.name != "SA") {
+            log << " " << runner.unit << "s=" << mean(units);
+        }
+        log << " stable=" << stable_runs << "/" << config.repeats
+                  << " time_limit=" << time_limit_runs << "/" << config.repeats;
+    }
+
+    log << "\n";
+}
+
 }
 
 void run_benchmark(const BenchmarkConfig& config) {
     if (config.repeats <= 0) {
         throw std::invalid_argument("repeats must be positive");
     }
+    if (config.jobs <= 0) {
+        throw std::invalid_argument("jobs must be positive");
+    }
     if (config.benchmark_mode == "timed" && !(config.time_limit > 0.0)) {
         throw std::invalid_argument("time limit must be positive");
     }
@@ -246,11 +429,12 @@ void run_benchmark(const BenchmarkConfig& config) {
     std::ofstream out = open_output_file("results", output_name);
     out << "algorithm,size_class,dataset,n,seed,repeats,parameters,unit,best_cost,mean_cost,stddev_cost,"
         << "best_known,best_gap_percent,mean_gap_percent,mean_time_sec,mean_units,"
-        << "stable_runs,time_limit_runs,iteration_limit_runs\n";
+        << "stable_runs,time_limit_runs,iteration_limit_runs,mean_fallbacks,preprocess_time_sec,"
+        << "mean_saved_copy_cities,load_time_sec\n";
 
     std::cout << "Benchmark mode=" << config.benchmark_mode << " group=" << config.group
               << " algorithm=" << config.algorithm << " params=" << config.params << " seed=" << config.seed
-              << " repeats=" << config.repeats;
+              << " repeats=" << config.repeats << " jobs=" << config.jobs;
 
     const std::string label = output_label(config);
 
@@ -267,96 +451,150 @@ void run_benchmark(const BenchmarkConfig& config) {
     }
     std::cout << "\n";
 
-    for (std::size_t dataset_index = 0; dataset_index < datasets.size(); ++dataset_index) {
-        const auto& dataset = datasets[dataset_index];
-        const double best_known = best_known_for(dataset.name);
+    // Runs are numbered dataset-major, then runner, then repeat. Workers take them in that order;
+    // finished (dataset, runner) groups are reported strictly in order, so the CSV and the
+    // summaries match a serial run whatever the job count.
+    InstanceRequirements requirements;
+    for (const auto& runner: runners) {
+        requirements.merge(runner.requirements);
+    }
 
+    std::vector<PreparedDataset> prepared(datasets.size());
+    std::vector<RunGroup> groups;
+    for (std::size_t dataset_index = 0; dataset_index < datasets.size(); ++dataset_index) {
         for (const auto& runner: runners) {
-            std::vector<double> costs;
-            std::vector<double> times;
-            std::vector<double> units;
-            int stable_runs = 0;
-            int time_limit_runs = 0;
-            int iteration_limit_runs = 0;
-            std::size_t n = 0;
+            groups.push_back({dataset_index, &runner, std::vector<RunOutcome>(static_cast<std::size_t>(config.repeats)),
+                              static_cast<std::size_t>(config.repeats)});
+        }
+    }
 
-            for (int repeat = 0; repeat < config.repeats; ++repeat) {
-                set_random_seed(derive_run_seed(config.seed, runner.id, dataset_index, static_cast<std::size_t>(repeat)));
+    const auto repeats = static_cast<std::size_t>(config.repeats);
+    const std::size_t total_runs = groups.size() * repeats;
+    std::atomic<std::size_t> next_run{0};
+    std::mutex output_mutex;
+    std::size_t next_report = 0;
+    std::exception_ptr failure;
+
+    // The first worker to claim one of a dataset's runs prepares it; others claiming its runs wait.
+    const auto prepare = [&](std::size_t dataset_index) -> const PreparedInstance& {
+        PreparedDataset& dataset = prepared[dataset_index];
+        const std::lock_guard<std::mutex> lock(dataset.mutex);
+        if (!dataset.instance) {
+            const auto start = std::chrono::steady_clock::now();
+            dataset.cache = std::make_unique<InstanceCache>(datasets[dataset_index].path);
+            dataset.load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            dataset.instance = std::make_unique<PreparedInstance>(*dataset.cache, requirements);
+            dataset.preprocess_seconds = dataset.instance->seconds();
+
+            const std::lock_guard<std::mutex> output_lock(output_mutex);
+            std::cout << "  [prepare] " << datasets[dataset_index].name << " (n=" << dataset.instance->size()
+                      << ") load=" << dataset.load_seconds << "s time=" << dataset.preprocess_seconds << "s\n"
+                      << std::flush;
+        }
+        return *dataset.instance;
+    };
 
-                std::vector<City> cities;
-                readfile(cities, dataset.path);
-                n = cities.size();
+    const auto worker = [&](std::size_t worker_index) {
+        if (config.pin_threads) {
+            pin_current_thread(worker_index);
+        }
+
+        for (std::size_t run = next_run++; run < total_runs; run = next_run++) {
+            RunGroup& group = groups[run / repeats];
+            const auto& dataset = datasets[group.dataset_index];
+            const AlgorithmRunner& runner = *group.runner;
+            const std::size_t repeat = run % repeats;
+
+            try {
+                const PreparedInstance& instance = prepare(group.dataset_index);
+                {
+                    const std::lock_guard<std::mutex> lock(output_mutex);
+                    if (failure) {
+                        return;
+                    }
+                    std::cout << "  [" << runner.name << "] " << dataset.name << " repeat "
+                              << (repeat + 1) << "/" << config.repeats << " started\n" << std::flush;
+                }
+
+                SolverContext context(derive_run_seed(config.seed, runner.id, group.dataset_index, repeat));
+                std::vector<City> cities = instance.cities();
 
                 StopCondition stop = base_stop;
                 if (runner.name == "SA") {
                     stop.progress_interval = sa_progress_interval(config.group);
                     stop.progress_callback = [&](std::size_t restarts_done, double best_cost) {
+                        const std::lock_guard<std::mutex> lock(output_mutex);
                         std::cout << "    [SA] " << dataset.name << " repeat " << (repeat + 1)
                                   << "/" << config.repeats << " restarts=" << restarts_done
                                   << " best=" << best_cost << "\n" << std::flush;
                     };
                 }
 
-                std::cout << "  [" << runner.name << "] " << dataset.name << " repeat "
-                          << (repeat + 1) << "/" << config.repeats << " started\n" << std::flush;
+                RunOutcome outcome;
+                outcome.n = cities.size();
 
                 const auto start = std::chrono::steady_clock::now();
-                const SolveResult result = runner.solve(cities, stop);
+                outcome.result = runner.solve(cities, instance, stop, context);
                 const auto end = std::chrono::steady_clock::now();
-                if (runner.name == "SA" && result.stop_reason == StopReason::TimeLimit && result.restarts == 0) {
-                    std::cout << "    [SA] warning: time limit expired before one full annealing restart completed\n"
-                              << std::flush;
-                }
 
                 validate_tour_input(cities, runner.name + " benchmark result");
-                costs.push_back(total_cost(cities));
-                times.push_back(std::chrono::duration<double>(end - start).count());
-                units.push_back(static_cast<double>(result.iterations));
-                stable_runs += result.stop_reason == StopReason::Stable ? 1 : 0;
-                time_limit_runs += result.stop_reason == StopReason::TimeLimit ? 1 : 0;
-                iteration_limit_runs += result.stop_reason == StopReason::IterationLimit ? 1 : 0;
-            }
+                outcome.cost = static_cast<double>(total_cost(cities));
+                outcome.seconds = std::chrono::duration<double>(end - start).count();
 
-            const double best_cost = *std::min_element(costs.begin(), costs.end());
-            const double mean_cost = mean(costs);
-            const double best_gap = gap_percent(best_cost, best_known);
-            const double mean_gap = gap_percent(mean_cost, best_known);
-
-            out << runner.name << "," << dataset.size_class << "," << dataset.name << "," << n << ","
-                << config.seed << "," << config.repeats << "," << runner.params_text << "," << runner.unit << ","
-                << best_cost << "," << mean_cost << "," << stddev(costs, mean_cost) << ",";
-            if (best_known > 0.0) {
-                out << best_known << "," << best_gap << "," << mean_gap;
-            } else {
-                out << ",,";
-            }
-            out << "," << mean(times) << "," << mean(units) << ","
-                << stable_runs << "," << time_limit_runs << "," << iteration_limit_runs << "\n";
-
-            std::cout << "  [" << runner.name << "] " << dataset.name << " (n=" << n << ") best=" << best_cost
-                      << " mean=" << mean_cost << " best_gap=";
-            if (best_known > 0.0) {
-                std::cout << best_gap << "%";
-            }
-            else {
-                std::cout << "n/a";
-            }
-
-            std::cout << " time=" << mean(times) << "s";
+                const std::lock_guard<std::mutex> lock(output_mutex);
+                if (runner.name == "SA" && outcome.result.stop_reason == StopReason::TimeLimit &&
+                    outcome.result.restarts == 0) {
+                    std::cout << "    [SA] warning: time limit expired before one full annealing restart completed\n"
+                              << std::flush;
+                }
 
-            if (runner.name == "SA") {
-                std::cout << " restart_attempts=" << mean(units);
+                group.runs[repeat] = outcome;
+                --group.remaining;
+
+                while (next_report < groups.size() && groups[next_report].remaining == 0) {
+                    const RunGroup& done = groups[next_report];
+                    PreparedDataset& done_dataset = prepared[done.dataset_index];
+                    report_group(out, std::cout, config, datasets[done.dataset_index], done_dataset.load_seconds,
+                                 done_dataset.preprocess_seconds, done);
+
+                    // The dataset's last runner is done: persist lists built for it and free them.
+                    if (++next_report % runners.size() == 0) {
+                        done_dataset.instance.reset();
+                        done_dataset.cache->save();
+                        done_dataset.cache.reset();
+                    }
+                }
             }
-            if (config.benchmark_mode == "stable") {
-                if (runner.name != "SA") {
-                    std::cout << " " << runner.unit << "s=" << mean(units);
+            catch (...) {
+                const std::lock_guard<std::mutex> lock(output_mutex);
+                if (!failure) {
+                    failure = std::current_exception();
                 }
-                std::cout << " stable=" << stable_runs << "/" << config.repeats
-                          << " time_limit=" << time_limit_runs << "/" << config.repeats;
+                return;
             }
-
-            std::cout << "\n";
         }
+    };
+
+    // A single unpinned worker runs on the calling thread. Pinned workers always get threads of their
+    // own, so the caller's affinity is unchanged after the benchmark returns.
+    const std::size_t workers =
+        std::max<std::size_t>(1, std::min<std::size_t>(static_cast<std::size_t>(config.jobs), total_runs));
+    if (workers == 1 && !config.pin_threads) {
+        worker(0);
+    }
+    else {
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+        for (std::size_t index = 0; index < workers; ++index) {
+            threads.emplace_back(worker, index);
+        }
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
     }
 
     std::cout << "Wrote results/" << output_name << "\n";
@@ -7,6 +7,8 @@
 #include <optional>
 #include <string>
 
+#include "../core/config.hpp"
+
 struct BenchmarkConfig {
     std::string benchmark_mode = "timed";
     std::string group = "small";
@@ -15,10 +17,15 @@ struct BenchmarkConfig {
     std::filesystem::path custom_config;
     std::string label;
     std::optional<bool> two_opt_override;
+    std::optional<CandidateKind> candidates_override;
+    std::optional<LocalSearch> local_search_override;
 
     double time_limit = 5.0;
     std::uint32_t seed = 42;
     int repeats = 3;
+    // Runs solved concurrently; results and CSV order do not depend on it.
+    int jobs = 1;
+    bool pin_threads = false;
 
     std::size_t min_iters = 50;
     std::size_t stable_window = 25;
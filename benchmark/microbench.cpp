@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "algorithms/genetic.hpp"
+#include "algorithms/sa.hpp"
+#include "core/config.hpp"
+#include "core/distance_kernels.hpp"
+#include "core/local_search.hpp"
+#include "core/tsp.hpp"
+
+// Micro-benchmarks for preprocessing and local-search kernels on TSPLIB instances.
+// Usage: tsp_microbench [instance ...]   (defaults to fnl4461 rl5915 for the matrix builders and
+// local search, and to pr1002 fnl4461 for SA moves and crossover, one on each side of the
+// crossover's bitmask limit)
+
+namespace {
+
+constexpr int REPEATS = 5;
+constexpr std::size_t LOCAL_SEARCH_NEIGHBORS = 10;
+constexpr std::size_t SA_STEPS = 20000000;
+constexpr std::size_t CROSSOVER_CHILDREN = 100000;
+
+double best_milliseconds(const std::function<void()>& run) {
+    double best = 0.0;
+
+    for (int repeat = 0; repeat < REPEATS; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto end = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+
+        best = repeat == 0 ? elapsed : std::min(best, elapsed);
+    }
+
+    return best;
+}
+
+// The single-threaded scalar builder the vectorized one replaced, kept as the reference.
+DistanceMatrix<std::int32_t> scalar_distance_matrix(const CoordinateDistance& coordinates) {
+    const std::size_t n = coordinates.size();
+
+    DistanceMatrix<std::int32_t> distance_matrix(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::int32_t* row = distance_matrix.row(i);
+
+        for (std::size_t j = 0; j < i; ++j) {
+            row[j] = coordinates(i, j);
+            distance_matrix.set(j, i, row[j]);
+        }
+    }
+
+    return distance_matrix;
+}
+
+// The order crossover genetic_order_crossover replaced, allocating the child and two flag vectors
+// per call, kept as the reference. Draws the slice like the library, so the children match.
+Tour flagged_order_crossover(const Tour& parent1, const Tour& parent2, Rng& rng) {
+    const std::size_t n = parent1.size();
+    const std::size_t length = rng.between(1, n >= 3 ? n - 2 : 1);
+    const std::size_t start = rng.below(n - length + 1);
+    const std::size_t end = start + length - 1;
+
+    Tour output(n);
+    std::vector<bool> copied_position(n, false);
+    std::vector<bool> used_city(n, false);
+    for (std::size_t i = start; i <= end; ++i) {
+        output[i] = parent1[i];
+        copied_position[i] = true;
+        used_city[parent1[i]] = true;
+    }
+
+    auto parent2_it = parent2.begin();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (copied_position[i]) {
+            continue;
+        }
+        while (used_city[*parent2_it]) {
+            ++parent2_it;
+        }
+        output[i] = *parent2_it;
+        used_city[*parent2_it] = true;
+    }
+
+    return output;
+}
+
+void report(const std::string& label, double milliseconds, double baseline) {
+    std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2) << milliseconds << " ms  x" << std::setprecision(2) << baseline / milliseconds
+              << "\n";
+}
+
+void bench_distance_matrix(const std::string& instance) {
+    std::vector<City> cities;
+    readfile(cities, (project_root() / "tsplib" / "tests" / (instance + ".tsp")).string());
+    const CoordinateDistance coordinates = build_coordinate_distance(cities);
+    const std::size_t n = cities.size();
+
+    const DistanceMatrix<std::int32_t> reference = scalar_distance_matrix(coordinates);
+    const DistanceMatrix<std::int32_t> dense = build_distance_matrix_as<std::int32_t>(cities);
+    const PackedDistanceMatrix<std::int32_t> packed = build_packed_distance_matrix_as<std::int32_t>(cities);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            if (dense(i, j) != reference(i, j) || packed(i, j) != reference(i, j)) {
+                throw std::runtime_error(instance + ": vectorized distances differ from the scalar reference");
+            }
+        }
+    }
+
+    std::cout << instance << " (n=" << n << ")\n";
+    const double baseline = best_milliseconds([&]() { scalar_distance_matrix(coordinates); });
+    report("scalar dense int32", baseline, baseline);
+    report("dense int32", best_milliseconds([&]() { build_distance_matrix_as<std::int32_t>(cities); }), baseline);
+    report("dense uint16", best_milliseconds([&]() { build_distance_matrix_as<std::uint16_t>(cities); }), baseline);
+    report("packed int32", best_milliseconds([&]() { build_packed_distance_matrix_as<std::int32_t>(cities); }),
+           baseline);
+    report("packed uint16", best_milliseconds([&]() { build_packed_distance_matrix_as<std::uint16_t>(cities); }),
+           baseline);
+}
+
+// Each local search, on both tour stores, from the same random tour to its local optimum: time
+// and tour length, so the engines can be compared at equal time as well as equal effort.
+void bench_local_search(const std::string& instance) {
+    std::vector<City> cities;
+    readfile(cities, (project_root() / "tsplib" / "tests" / (instance + ".tsp")).string());
+    const auto distances = build_distance_matrix_as<std::int32_t>(cities);
+    const NeighborLists neighbors = build_neighbor_lists(distances, cities.size(), LOCAL_SEARCH_NEIGHBORS);
+
+    Tour start = to_tour(cities);
+    Rng rng;
+    shuffle_range(start.begin(), start.end(), rng);
+
+    std::cout << instance << " local search from a random tour (length " << total_cost_unchecked(start, distances)
+              << ")\n";
+    for (const LocalSearch kind: {LocalSearch::TwoOpt, LocalSearch::OrOpt, LocalSearch::LinKernighan}) {
+        for (const std::string store: {"array", "two_level"}) {
+            setenv("TSP_TOUR_STORE", store.c_str(), 1);
+
+            Tour tour = start;
+            const auto begin = std::chrono::steady_clock::now();
+            const std::size_t moves = local_search_unchecked(tour, distances, neighbors, kind,
+                                                             std::numeric_limits<std::size_t>::max());
+            const double elapsed =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+            std::cout << "  " << std::left << std::setw(28) << (local_search_text(kind) + " " + store) << std::right
+                      << std::setw(10) << std::fixed << std::setprecision(2) << elapsed
+                      << " ms  length=" << total_cost_unchecked(tour, distances) << " moves=" << moves << "\n";
+        }
+    }
+    unsetenv("TSP_TOUR_STORE");
+}
+
+// Segment-reversal SA steps per second, one proposal and exp at a time against batches of eight,
+// on dense and packed storage of both element types. The chain starts from a 2-opt local optimum
+// at a temperature where few moves pass, as in the long cold end of a run, so the time goes into
+// evaluating proposals.
+template <typename Matrix>
+void bench_sa_moves(const std::vector<City>& cities, const Matrix& distances, const std::string& storage) {
+    const NeighborLists neighbors = build_neighbor_lists(distances, cities.size(), LOCAL_SEARCH_NEIGHBORS);
+
+    Tour start = to_tour(cities);
+    Rng rng;
+    shuffle_range(start.begin(), start.end(), rng);
+    local_search_unchecked(start, distances, neighbors, LocalSearch::TwoOpt, std::numeric_limits<std::size_t>::max());
+    const double temperature = static_cast<double>(total_cost_unchecked(start, distances)) /
+                               static_cast<double>(cities.size()) / 10.0;
+
+    double baseline = 0.0;
+    for (const bool batched: {false, true}) {
+        Tour tour = start;
+        Rng steps_rng;
+        const auto begin = std::chrono::steady_clock::now();
+        sa_reversal_steps(tour, distances, temperature, SA_STEPS, batched, steps_rng);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const double moves_per_second = static_cast<double>(SA_STEPS) / seconds;
+        baseline = batched ? baseline : moves_per_second;
+
+        std::cout << "  " << std::left << std::setw(28) << (std::string(batched ? "batched " : "scalar ") + storage)
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(2) << moves_per_second / 1e6
+                  << " M moves/s  x" << moves_per_second / baseline << "  length=" << total_cost_unchecked(tour, distances)
+                  << "\n";
+    }
+}
+
+template <typename T>
+void bench_sa_moves(const std::vector<City>& cities) {
+    const char* type = sizeof(T) == 2 ? " uint16" : " int32";
+    bench_sa_moves(cities, build_distance_matrix_as<T>(cities), std::string("dense") + type);
+    bench_sa_moves(cities, build_packed_distance_matrix_as<T>(cities), std::string("packed") + type);
+}
+
+void bench_sa_moves(const std::string& instance) {
+    std::vector<City> cities;
+    readfile(cities, (project_root() / "tsplib" / "tests" / (instance + ".tsp")).string());
+
+    std::cout << instance << " SA segment reversals (" << SA_STEPS << " steps)\n";
+    bench_sa_moves<std::int32_t>(cities);
+    if (max_distance_bound(cities) <= std::numeric_limits<std::uint16_t>::max()) {
+        bench_sa_moves<std::uint16_t>(cities);
+    }
+}
+
+// Order crossover children per second between two random parents: the allocating reference, the
+// Tour overload and the caller-storage overload, which marks cities in a bitmask up to
+// CROSSOVER_BITMASK_CITIES and in a stamped workspace above it.
+void bench_crossover(const std::string& instance) {
+    std::vector<City> cities;
+    readfile(cities, (project_root() / "tsplib" / "tests" / (instance + ".tsp")).string());
+    const std::size_t n = cities.size();
+
+    Tour parent1 = to_tour(cities);
+    Tour parent2 = parent1;
+    Rng rng;
+    shuffle_range(parent1.begin(), parent1.end(), rng);
+    shuffle_range(parent2.begin(), parent2.end(), rng);
+
+    std::cout << instance << " order crossover (" << CROSSOVER_CHILDREN << " children)\n";
+    const std::string storage = n <= CROSSOVER_BITMASK_CITIES ? "bitmask" : "stamped";
+
+    const std::string labels[] = {"vector<bool> reference", "Tour overload", "caller storage " + storage};
+
+    double baseline = 0.0;
+    std::uint64_t reference_checksum = 0;
+    for (std::size_t variant = 0; variant < 3; ++variant) {
+        Rng children_rng;
+        SolverContext context;
+        CrossoverWorkspace workspace;
+        Tour child(n);
+        std::uint64_t checksum = 0;
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < CROSSOVER_CHILDREN; ++i) {
+            if (variant == 0) {
+                child = flagged_order_crossover(parent1, parent2, children_rng);
+            }
+            else if (variant == 1) {
+                child = genetic_order_crossover(parent1, parent2, context);
+            }
+            else {
+                genetic_order_crossover(parent1.data(), parent2.data(), n, child.data(), workspace, children_rng);
+            }
+            checksum = checksum * 31 + child[i % n];
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const double children_per_second = static_cast<double>(CROSSOVER_CHILDREN) / seconds;
+
+        if (variant == 0) {
+            baseline = children_per_second;
+            reference_checksum = checksum;
+        }
+        else if (checksum != reference_checksum) {
+            throw std::runtime_error(instance + ": " + labels[variant] + " children differ from the reference");
+        }
+        std::cout << "  " << std::left << std::setw(28) << labels[variant] << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(2) << children_per_second / 1e3 << " k children/s  x"
+                  << children_per_second / baseline << "\n";
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> instances(argv + 1, argv + argc);
+    std::vector<std::string> move_instances = instances;
+    if (instances.empty()) {
+        instances = {"fnl4461", "rl5915"};
+        move_instances = {"pr1002", "fnl4461"};
+    }
+
+    std::cout << "distance kernel=" << euc2d_kernel_name() << " threads=" << std::thread::hardware_concurrency()
+              << " repeats=" << REPEATS << " (best time, speedup over scalar)\n";
+
+    try {
+        for (const auto& instance: instances) {
+            bench_distance_matrix(instance);
+        }
+        for (const auto& instance: instances) {
+            bench_local_search(instance);
+        }
+        for (const auto& instance: move_instances) {
+            bench_sa_moves(instance);
+        }
+        for (const auto& instance: move_instances) {
+            bench_crossover(instance);
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
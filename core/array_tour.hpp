@@ -0,0 +1,101 @@
+#ifndef TSP_CORE_ARRAY_TOUR
+#define TSP_CORE_ARRAY_TOUR
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "tsp.hpp"
+
+// The tour as a city array plus each city's position: O(1) lookups, but a reversal swaps up to
+// n/2 cities. Same interface as TwoLevelTour, which the neighbor-list local search can use
+// instead; simulated annealing applies its neighbor moves to one too.
+class ArrayTour {
+public:
+    // pos is scratch storage for each city's position.
+    ArrayTour(Tour& path, std::vector<std::uint32_t>& pos) : path_(path.data()), n_(path.size()) {
+        pos.resize(n_);
+        pos_ = pos.data();
+        for (std::size_t i = 0; i < n_; ++i) {
+            pos_[path_[i]] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // An n-city tour stored at path whose positions pos already holds; both are updated in place.
+    ArrayTour(std::uint32_t* path, std::uint32_t* pos, std::size_t n) : path_(path), n_(n), pos_(pos) {}
+
+    std::size_t size() const { return n_; }
+    void write(Tour& tour) const { tour.assign(path_, path_ + n_); }
+    std::size_t next(std::size_t city) const { return path_[(pos_[city] + 1) % n_]; }
+    std::size_t prev(std::size_t city) const { return path_[(pos_[city] + n_ - 1) % n_]; }
+
+    // Reverses the forward path from..to, or the complementary arc when that is shorter.
+    void reverse(std::size_t from, std::size_t to) {
+        std::size_t i = pos_[from];
+        std::size_t j = pos_[to];
+        std::size_t len = (j >= i) ? (j - i + 1) : (n_ - i + j + 1);
+        if (len > n_ - len) {
+            const std::size_t ni = (j + 1) % n_;
+            const std::size_t nj = (i + n_ - 1) % n_;
+            i = ni;
+            j = nj;
+            len = n_ - len;
+        }
+        for (std::size_t s = 0; s < len / 2; ++s) {
+            std::swap(path_[i], path_[j]);
+            pos_[path_[i]] = static_cast<std::uint32_t>(i);
+            pos_[path_[j]] = static_cast<std::uint32_t>(j);
+            i = (i + 1 == n_) ? 0 : i + 1;
+            j = (j == 0) ? n_ - 1 : j - 1;
+        }
+    }
+
+    // Moves the short forward path first..last between after and its successor, shifting
+    // whichever side of the tour between them is shorter.
+    void move_segment(std::size_t first, std::size_t last, std::size_t after, bool reversed) {
+        const std::size_t start = pos_[first];
+        const std::size_t len = (pos_[last] + n_ - start) % n_ + 1;
+
+        std::uint32_t segment[MAX_SEGMENT];
+        for (std::size_t i = 0; i < len; ++i) {
+            segment[i] = path_[(start + i) % n_];
+        }
+
+        const std::size_t forward = (pos_[after] + 2 * n_ - start - len) % n_ + 1;
+        const std::size_t backward = n_ - len - forward;
+        std::size_t target = 0;
+
+        if (forward <= backward) {
+            for (std::size_t i = 0; i < forward; ++i) {
+                place((start + i) % n_, path_[(start + len + i) % n_]);
+            }
+            target = (start + forward) % n_;
+        }
+        else {
+            for (std::size_t i = 1; i <= backward; ++i) {
+                place((start + len + n_ - i) % n_, path_[(start + n_ - i) % n_]);
+            }
+            target = (start + n_ - backward) % n_;
+        }
+
+        for (std::size_t i = 0; i < len; ++i) {
+            place((target + i) % n_, segment[reversed ? len - 1 - i : i]);
+        }
+    }
+
+    // Longest path move_segment accepts.
+    static constexpr std::size_t MAX_SEGMENT = 3;
+
+private:
+    void place(std::size_t position, std::uint32_t city) {
+        path_[position] = city;
+        pos_[city] = static_cast<std::uint32_t>(position);
+    }
+
+    std::uint32_t* path_;
+    std::size_t n_;
+    std::uint32_t* pos_;
+};
+
+#endif
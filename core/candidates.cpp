@@ -0,0 +1,480 @@
+#include "candidates.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <utility>
+
+#include "delaunay.hpp"
+#include "kd_tree.hpp"
+
+namespace {
+
+// Alpha values are computed on the symmetric closure of a quadrant candidate pool rather than on
+// all n^2 pairs, which keeps the 1-tree sparse and the whole build near O(n log n) per iteration.
+constexpr std::size_t ALPHA_POOL_SIZE = 12;
+constexpr int ASCENT_ITERATIONS = 50;
+constexpr double INITIAL_STEP = 0.2;
+constexpr std::uint32_t SPECIAL = 0;
+
+struct Edge {
+    std::uint32_t a;
+    std::uint32_t b;
+    std::int32_t distance;
+};
+
+class DisjointSets {
+public:
+    explicit DisjointSets(std::size_t n) : parent_(n) {
+        std::iota(parent_.begin(), parent_.end(), std::uint32_t{0});
+    }
+
+    std::uint32_t find(std::uint32_t x) {
+        while (parent_[x] != x) {
+            parent_[x] = parent_[parent_[x]];
+            x = parent_[x];
+        }
+        return x;
+    }
+
+    // Attaches b's set below a's, so the caller knows which root survives.
+    bool unite(std::uint32_t a, std::uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) {
+            return false;
+        }
+        parent_[b] = a;
+        return true;
+    }
+
+private:
+    std::vector<std::uint32_t> parent_;
+};
+
+// Minimum 1-tree under penalties pi: a spanning tree over every city but SPECIAL plus SPECIAL's
+// two cheapest edges. Tree edges are listed in ascending transformed weight.
+struct OneTree {
+    std::vector<std::uint32_t> tree;
+    std::vector<int> degree;
+    double length = 0.0;
+    double special_second = 0.0;
+};
+
+bool closer(const Neighbor& a, const Neighbor& b) {
+    return a.distance != b.distance ? a.distance < b.distance : a.city < b.city;
+}
+
+NeighborLists empty_lists(std::size_t n) {
+    NeighborLists neighbors;
+    for (std::size_t city = 0; city < n; ++city) {
+        neighbors.append(nullptr, nullptr);
+    }
+    return neighbors;
+}
+
+}
+
+NeighborLists build_neighbor_lists(const std::vector<City>& cities, std::size_t k) {
+    const KdTree tree(build_coordinate_distance(cities));
+    const std::size_t n = cities.size();
+    const std::size_t limit = n > 0 ? std::min(k, n - 1) : 0;
+
+    if (limit == 0) {
+        return empty_lists(n);
+    }
+
+    std::vector<Neighbor> entries(n * limit);
+    std::vector<Neighbor> nearest;
+    for (const std::uint32_t city: tree.order()) {
+        tree.nearest(city, limit, nearest);
+        std::copy(nearest.begin(), nearest.end(), entries.begin() + static_cast<std::ptrdiff_t>(city * limit));
+    }
+
+    return {std::move(entries), limit};
+}
+
+NeighborLists build_quadrant_neighbor_lists(const std::vector<City>& cities, std::size_t k) {
+    const KdTree tree(build_coordinate_distance(cities));
+    const std::size_t n = cities.size();
+    const std::size_t limit = n > 0 ? std::min(k, n - 1) : 0;
+    const std::size_t per_quadrant = std::max<std::size_t>(1, limit / 4);
+
+    if (limit == 0) {
+        return empty_lists(n);
+    }
+
+    // Quadrants are disjoint, so their picks never repeat; the overall k nearest always hold
+    // enough fresh cities to fill every list to exactly limit entries.
+    std::vector<Neighbor> entries(n * limit);
+    std::vector<Neighbor> chosen;
+    std::vector<Neighbor> found;
+    for (const std::uint32_t city: tree.order()) {
+        chosen.clear();
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            tree.nearest_in_quadrant(city, quadrant, std::min(per_quadrant, limit - chosen.size()), found);
+            chosen.insert(chosen.end(), found.begin(), found.end());
+        }
+
+        tree.nearest(city, limit, found);
+        for (const Neighbor& candidate: found) {
+            if (chosen.size() == limit) {
+                break;
+            }
+            const bool taken = std::any_of(chosen.begin(), chosen.end(),
+                                           [&](const Neighbor& other) { return other.city == candidate.city; });
+            if (!taken) {
+                chosen.push_back(candidate);
+            }
+        }
+
+        std::sort(chosen.begin(), chosen.end(), closer);
+        std::copy(chosen.begin(), chosen.end(), entries.begin() + static_cast<std::ptrdiff_t>(city * limit));
+    }
+
+    return {std::move(entries), limit};
+}
+
+namespace {
+
+double transformed(const Edge& edge, const std::vector<double>& pi) {
+    return static_cast<double>(edge.distance) + pi[edge.a] + pi[edge.b];
+}
+
+// Undirected pool edges (a < b), each listed once.
+std::vector<Edge> pool_edges(const NeighborLists& pool) {
+    std::vector<Edge> edges;
+    edges.reserve(pool.entries());
+
+    for (std::size_t city = 0; city < pool.size(); ++city) {
+        for (const Neighbor& neighbor: pool[city]) {
+            const auto a = static_cast<std::uint32_t>(std::min<std::size_t>(city, neighbor.city));
+            const auto b = static_cast<std::uint32_t>(std::max<std::size_t>(city, neighbor.city));
+            edges.push_back({a, b, neighbor.distance});
+        }
+    }
+
+    std::sort(edges.begin(), edges.end(),
+              [](const Edge& x, const Edge& y) { return x.a != y.a ? x.a < y.a : x.b < y.b; });
+    edges.erase(std::unique(edges.begin(), edges.end(),
+                            [](const Edge& x, const Edge& y) { return x.a == y.a && x.b == y.b; }),
+                edges.end());
+    return edges;
+}
+
+// Quadrant pools are connected in practice; if not, chain the components with real edges so a
+// spanning tree over the non-special cities always exists.
+void connect_components(std::vector<Edge>& edges, const CoordinateDistance& coordinates) {
+    const std::size_t n = coordinates.size();
+    DisjointSets sets(n);
+
+    for (const Edge& edge: edges) {
+        if (edge.a != SPECIAL) {
+            sets.unite(edge.a, edge.b);
+        }
+    }
+
+    std::uint32_t previous = 1;
+    for (std::uint32_t city = 2; city < n; ++city) {
+        if (sets.unite(previous, city)) {
+            edges.push_back({previous, city, coordinates(previous, city)});
+            previous = city;
+        }
+    }
+}
+
+OneTree minimum_one_tree(const std::vector<Edge>& edges, const std::vector<double>& pi) {
+    const std::size_t n = pi.size();
+    OneTree result;
+    result.degree.assign(n, 0);
+
+    std::vector<double> weight(edges.size());
+    std::vector<std::uint32_t> order;
+    order.reserve(edges.size());
+
+    double first = std::numeric_limits<double>::infinity();
+    double second = first;
+    std::uint32_t first_city = SPECIAL;
+    std::uint32_t second_city = SPECIAL;
+
+    for (std::size_t e = 0; e < edges.size(); ++e) {
+        weight[e] = transformed(edges[e], pi);
+        if (edges[e].a != SPECIAL) {
+            order.push_back(static_cast<std::uint32_t>(e));
+        }
+        else if (weight[e] < first) {
+            second = first;
+            second_city = first_city;
+            first = weight[e];
+            first_city = edges[e].b;
+        }
+        else if (weight[e] < second) {
+            second = weight[e];
+            second_city = edges[e].b;
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [&](std::uint32_t x, std::uint32_t y) { return weight[x] < weight[y]; });
+
+    DisjointSets sets(n);
+    result.tree.reserve(n - 2);
+    for (const std::uint32_t e: order) {
+        if (sets.unite(edges[e].a, edges[e].b)) {
+            result.tree.push_back(e);
+            result.length += weight[e];
+            ++result.degree[edges[e].a];
+            ++result.degree[edges[e].b];
+            if (result.tree.size() == n - 2) {
+                break;
+            }
+        }
+    }
+
+    result.length += first + second;
+    result.special_second = second;
+    result.degree[SPECIAL] = 2;
+    ++result.degree[first_city];
+    ++result.degree[second_city];
+    return result;
+}
+
+// Held-Karp subgradient ascent; returns the penalties of the best lower bound seen.
+std::vector<double> ascend(const std::vector<Edge>& edges, std::size_t n) {
+    std::vector<double> pi(n, 0.0);
+    std::vector<double> best_pi = pi;
+    std::vector<int> last_slope(n, 0);
+    double best_bound = -std::numeric_limits<double>::infinity();
+    double step = 0.0;
+
+    for (int iteration = 0; iteration < ASCENT_ITERATIONS; ++iteration) {
+        const OneTree one_tree = minimum_one_tree(edges, pi);
+        const double bound = one_tree.length - 2.0 * std::accumulate(pi.begin(), pi.end(), 0.0);
+
+        if (bound > best_bound) {
+            best_bound = bound;
+            best_pi = pi;
+        }
+        if (iteration == 0) {
+            step = INITIAL_STEP * one_tree.length / static_cast<double>(n);
+        }
+
+        // Every degree is 2: the 1-tree is a tour and the bound cannot improve.
+        if (std::all_of(one_tree.degree.begin(), one_tree.degree.end(), [](int degree) { return degree == 2; })) {
+            break;
+        }
+
+        const double t = step * static_cast<double>(ASCENT_ITERATIONS - iteration) / ASCENT_ITERATIONS;
+        for (std::size_t city = 0; city < n; ++city) {
+            const int slope = one_tree.degree[city] - 2;
+            pi[city] += t * (0.7 * slope + 0.3 * last_slope[city]);
+            last_slope[city] = slope;
+        }
+    }
+
+    return best_pi;
+}
+
+// Alpha of every pool edge: its transformed weight minus the heaviest edge on the 1-tree path
+// between its endpoints. Path maxima come from an offline LCA (Tarjan) over the Kruskal
+// reconstruction tree, whose internal node for a tree edge is the LCA of everything it joined.
+std::vector<double> alpha_values(const std::vector<Edge>& edges, const std::vector<double>& pi) {
+    const std::size_t n = pi.size();
+    const OneTree one_tree = minimum_one_tree(edges, pi);
+
+    std::vector<double> alpha(edges.size(), 0.0);
+    std::vector<std::uint32_t> incident_offsets(n + 1, 0);
+    for (const Edge& edge: edges) {
+        ++incident_offsets[edge.a + 1];
+        ++incident_offsets[edge.b + 1];
+    }
+    std::partial_sum(incident_offsets.begin(), incident_offsets.end(), incident_offsets.begin());
+
+    std::vector<std::uint32_t> incident(incident_offsets.back());
+    std::vector<std::uint32_t> fill(incident_offsets.begin(), incident_offsets.end() - 1);
+    for (std::size_t e = 0; e < edges.size(); ++e) {
+        incident[fill[edges[e].a]++] = static_cast<std::uint32_t>(e);
+        incident[fill[edges[e].b]++] = static_cast<std::uint32_t>(e);
+    }
+
+    const std::size_t nodes = 2 * n;
+    std::vector<std::array<std::uint32_t, 2>> children(nodes);
+    std::vector<double> heaviest(nodes, 0.0);
+    std::vector<std::uint32_t> component_node(n);
+    std::iota(component_node.begin(), component_node.end(), std::uint32_t{0});
+
+    DisjointSets components(n);
+    std::uint32_t next = static_cast<std::uint32_t>(n);
+    for (const std::uint32_t e: one_tree.tree) {
+        const std::uint32_t a = components.find(edges[e].a);
+        const std::uint32_t b = components.find(edges[e].b);
+        children[next] = {component_node[a], component_node[b]};
+        heaviest[next] = transformed(edges[e], pi);
+        components.unite(a, b);
+        component_node[a] = next++;
+    }
+
+    DisjointSets merged(nodes);
+    std::vector<std::uint32_t> ancestor(nodes);
+    std::iota(ancestor.begin(), ancestor.end(), std::uint32_t{0});
+    std::vector<char> visited(n, 0);
+
+    auto finish = [&](std::vector<std::pair<std::uint32_t, int>>& stack, std::uint32_t node) {
+        if (!stack.empty()) {
+            const std::uint32_t parent = stack.back().first;
+            merged.unite(parent, node);
+            ancestor[merged.find(parent)] = parent;
+        }
+    };
+
+    std::vector<std::pair<std::uint32_t, int>> stack;
+    stack.push_back({next - 1, 0});
+    while (!stack.empty()) {
+        const std::uint32_t node = stack.back().first;
+
+        if (node < n) {
+            visited[node] = 1;
+            for (std::uint32_t slot = incident_offsets[node]; slot < incident_offsets[node + 1]; ++slot) {
+                const Edge& edge = edges[incident[slot]];
+                const std::uint32_t other = edge.a == node ? edge.b : edge.a;
+                if (other != SPECIAL && visited[other]) {
+                    alpha[incident[slot]] = transformed(edge, pi) - heaviest[ancestor[merged.find(other)]];
+                }
+            }
+            stack.pop_back();
+            finish(stack, node);
+        }
+        else if (stack.back().second < 2) {
+            const std::uint32_t child = children[node][static_cast<std::size_t>(stack.back().second++)];
+            stack.push_back({child, 0});
+        }
+        else {
+            stack.pop_back();
+            finish(stack, node);
+        }
+    }
+
+    for (std::uint32_t slot = incident_offsets[SPECIAL]; slot < incident_offsets[SPECIAL + 1]; ++slot) {
+        const Edge& edge = edges[incident[slot]];
+        alpha[incident[slot]] = std::max(0.0, transformed(edge, pi) - one_tree.special_second);
+    }
+
+    return alpha;
+}
+
+}
+
+NeighborLists build_alpha_neighbor_lists(const std::vector<City>& cities, std::size_t k) {
+    const std::size_t n = cities.size();
+
+    // With every other city a candidate, alpha cannot change the selection.
+    if (n < 4 || k + 1 >= n) {
+        return build_neighbor_lists(cities, k);
+    }
+
+    const CoordinateDistance coordinates = build_coordinate_distance(cities);
+    std::vector<Edge> edges = pool_edges(build_quadrant_neighbor_lists(cities, std::max(ALPHA_POOL_SIZE, 2 * k)));
+    connect_components(edges, coordinates);
+
+    const std::vector<double> alpha = alpha_values(edges, ascend(edges, n));
+
+    std::vector<std::vector<std::pair<double, Neighbor>>> ranked(n);
+    for (std::size_t e = 0; e < edges.size(); ++e) {
+        ranked[edges[e].a].push_back({alpha[e], {edges[e].b, edges[e].distance}});
+        ranked[edges[e].b].push_back({alpha[e], {edges[e].a, edges[e].distance}});
+    }
+
+    std::vector<Neighbor> entries(n * k);
+    for (std::size_t city = 0; city < n; ++city) {
+        auto& list = ranked[city];
+        const auto by_alpha = [](const std::pair<double, Neighbor>& x, const std::pair<double, Neighbor>& y) {
+            if (x.first != y.first) {
+                return x.first < y.first;
+            }
+            return closer(x.second, y.second);
+        };
+        std::partial_sort(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(k), list.end(), by_alpha);
+
+        const auto first = entries.begin() + static_cast<std::ptrdiff_t>(city * k);
+        std::transform(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(k), first,
+                       [](const std::pair<double, Neighbor>& ranked_entry) { return ranked_entry.second; });
+        std::sort(first, first + static_cast<std::ptrdiff_t>(k), closer);
+    }
+
+    return {std::move(entries), k};
+}
+
+NeighborLists build_delaunay_neighbor_lists(const std::vector<City>& cities, std::size_t k) {
+    const CoordinateDistance coordinates = build_coordinate_distance(cities);
+    const std::size_t n = cities.size();
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> edges = delaunay_edges(coordinates);
+
+    std::vector<std::uint32_t> offsets(n + 1, 0);
+    for (const auto& [a, b]: edges) {
+        ++offsets[a + 1];
+        ++offsets[b + 1];
+    }
+
+    // Cities left out of the triangulation (coincident points) take their nearest cities
+    // instead, in both directions, so every city stays reachable.
+    std::vector<Neighbor> nearest;
+    std::optional<KdTree> tree;
+    for (std::uint32_t city = 0; city < n; ++city) {
+        if (offsets[city + 1] != 0 || n < 2) {
+            continue;
+        }
+        if (!tree) {
+            tree.emplace(coordinates);
+        }
+        tree->nearest(city, k, nearest);
+        for (const Neighbor& neighbor: nearest) {
+            edges.emplace_back(std::min(city, neighbor.city), std::max(city, neighbor.city));
+        }
+    }
+    if (tree) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const auto& [a, b]: edges) {
+            ++offsets[a + 1];
+            ++offsets[b + 1];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<Neighbor> adjacent(offsets.back());
+    std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& [a, b]: edges) {
+        const std::int32_t distance = coordinates(a, b);
+        adjacent[fill[a]++] = {b, distance};
+        adjacent[fill[b]++] = {a, distance};
+    }
+
+    NeighborLists neighbors;
+    neighbors.reserve(n, std::min<std::size_t>(adjacent.size(), n * k));
+    for (std::size_t city = 0; city < n; ++city) {
+        Neighbor* first = adjacent.data() + offsets[city];
+        Neighbor* last = adjacent.data() + offsets[city + 1];
+
+        std::sort(first, last, closer);
+        last = std::unique(first, last, [](const Neighbor& x, const Neighbor& y) { return x.city == y.city; });
+        neighbors.append(first, first + std::min<std::ptrdiff_t>(last - first, static_cast<std::ptrdiff_t>(k)));
+    }
+
+    return neighbors;
+}
+
+NeighborLists build_candidate_lists(const std::vector<City>& cities, CandidateKind kind, std::size_t k) {
+    switch (kind) {
+        case CandidateKind::Alpha:
+            return build_alpha_neighbor_lists(cities, std::min(k, ALPHA_CANDIDATES));
+        case CandidateKind::Quadrant:
+            return build_quadrant_neighbor_lists(cities, k);
+        case CandidateKind::Delaunay:
+            return build_delaunay_neighbor_lists(cities, k);
+        case CandidateKind::Nearest:
+            break;
+    }
+
+    return build_neighbor_lists(cities, k);
+}
@@ -0,0 +1,34 @@
+#ifndef TSP_CORE_CANDIDATES
+#define TSP_CORE_CANDIDATES
+
+#include <cstddef>
+#include <vector>
+
+#include "config.hpp"
+#include "tsp.hpp"
+
+// k nearest cities of every city, found with a k-d tree over the coordinates in O(n log n).
+// Produces exactly the lists of the distance-based build_neighbor_lists, ties included.
+NeighborLists build_neighbor_lists(const std::vector<City>& cities, std::size_t k);
+
+// Up to k / 4 nearest cities from each quadrant around every city, topped up with the overall
+// nearest to k entries. Keeps edges towards neighboring clusters that plain nearest-k drops.
+NeighborLists build_quadrant_neighbor_lists(const std::vector<City>& cities, std::size_t k);
+
+// Number of alpha-nearness candidates solvers use in place of their larger nearest-k lists.
+constexpr std::size_t ALPHA_CANDIDATES = 5;
+
+// The k pool neighbors of every city with the smallest alpha-nearness: how much a minimum 1-tree
+// must grow to include the edge, under Held-Karp penalties from a subgradient ascent (as in LKH).
+// The pool is the quadrant candidate set, so alpha is exact only relative to that sparse graph.
+// Lists are stored sorted by distance like every other NeighborLists.
+NeighborLists build_alpha_neighbor_lists(const std::vector<City>& cities, std::size_t k);
+
+// Delaunay neighbors of every city, at most k of them, sorted by distance. The triangulation
+// has O(n) edges and keeps nearly every edge of good tours with far shorter lists than nearest-k.
+NeighborLists build_delaunay_neighbor_lists(const std::vector<City>& cities, std::size_t k);
+
+// Alpha lists are capped at ALPHA_CANDIDATES entries per city.
+NeighborLists build_candidate_lists(const std::vector<City>& cities, CandidateKind kind, std::size_t k);
+
+#endif
@@ -142,6 +142,115 @@ bool config_bool(const ConfigMap& values, const std::string& key) {
     throw std::runtime_error("invalid boolean for config key " + key + ": " + text);
 }
 
+std::string config_text(const ConfigMap& values, const std::string& key, const std::string& fallback) {
+    const auto found = values.find(key);
+
+    return found == values.end() ? fallback : found->second;
+}
+
+CandidateKind parse_candidate_kind(const std::string& text) {
+    if (text == "nearest") {
+        return CandidateKind::Nearest;
+    }
+    if (text == "quadrant") {
+        return CandidateKind::Quadrant;
+    }
+    if (text == "alpha") {
+        return CandidateKind::Alpha;
+    }
+    if (text == "delaunay") {
+        return CandidateKind::Delaunay;
+    }
+
+    throw std::runtime_error("invalid candidates: '" + text + "' (expected nearest, quadrant, alpha or delaunay)");
+}
+
+std::string candidate_kind_text(CandidateKind kind) {
+    switch (kind) {
+        case CandidateKind::Quadrant:
+            return "quadrant";
+        case CandidateKind::Alpha:
+            return "alpha";
+        case CandidateKind::Delaunay:
+            return "delaunay";
+        case CandidateKind::Nearest:
+            break;
+    }
+
+    return "nearest";
+}
+
+LocalSearch parse_local_search(const std::string& text) {
+    if (text == "two_opt") {
+        return LocalSearch::TwoOpt;
+    }
+    if (text == "or_opt") {
+        return LocalSearch::OrOpt;
+    }
+    if (text == "lin_kernighan") {
+        return LocalSearch::LinKernighan;
+    }
+
+    throw std::runtime_error("invalid local_search: '" + text + "' (expected two_opt, or_opt or lin_kernighan)");
+}
+
+std::string local_search_text(LocalSearch kind) {
+    switch (kind) {
+        case LocalSearch::OrOpt:
+            return "or_opt";
+        case LocalSearch::LinKernighan:
+            return "lin_kernighan";
+        case LocalSearch::TwoOpt:
+            break;
+    }
+
+    return "two_opt";
+}
+
+SaMoves parse_sa_moves(const std::string& text) {
+    if (text == "segment") {
+        return SaMoves::Segment;
+    }
+    if (text == "neighbor") {
+        return SaMoves::Neighbor;
+    }
+
+    throw std::runtime_error("invalid moves: '" + text + "' (expected segment or neighbor)");
+}
+
+std::string sa_moves_text(SaMoves moves) {
+    switch (moves) {
+        case SaMoves::Segment:
+            return "segment";
+        case SaMoves::Neighbor:
+            break;
+    }
+
+    return "neighbor";
+}
+
+SaSchedule parse_sa_schedule(const std::string& text) {
+    if (text == "fixed") {
+        return SaSchedule::Fixed;
+    }
+    if (text == "adaptive") {
+        return SaSchedule::Adaptive;
+    }
+
+    throw std::runtime_error("invalid schedule: '" + text + "' (expected fixed or adaptive)");
+}
+
+std::string sa_schedule_text(SaSchedule schedule) {
+    switch (schedule) {
+        case SaSchedule::Adaptive:
+            return "adaptive";
+        case SaSchedule::Fixed:
+            break;
+    }
+
+    return "fixed";
+}
+
 SaParams sa_params_from(const ConfigMap& values) {
     SaParams params;
 
@@ -149,6 +258,12 @@ SaParams sa_params_from(const ConfigMap& values) {
     params.end_temp = config_double(values, "end_temp");
     params.cooling = config_double(values, "cooling");
     params.two_opt = config_bool(values, "two_opt");
+    params.candidates = parse_candidate_kind(config_text(values, "candidates", "nearest"));
+    params.local_search = parse_local_search(config_text(values, "local_search", "two_opt"));
+    params.moves = parse_sa_moves(config_text(values, "moves", "neighbor"));
+    params.schedule = parse_sa_schedule(config_text(values, "schedule", "fixed"));
+    params.reheats = values.count("reheats") ? config_int(values, "reheats") : 0;
+    params.replicas = values.count("replicas") ? config_int(values, "replicas") : 1;
 
     return params;
 }
@@ -159,6 +274,8 @@ GaParams ga_params_from(const ConfigMap& values) {
     params.population = config_int(values, "population");
     params.mutation = config_double(values, "mutation");
     params.two_opt = config_bool(values, "two_opt");
+    params.candidates = parse_candidate_kind(config_text(values, "candidates", "nearest"));
+    params.local_search = parse_local_search(config_text(values, "local_search", "two_opt"));
 
     return params;
 }
@@ -171,6 +288,8 @@ AcoParams aco_params_from(const ConfigMap& values) {
     params.beta = config_double(values, "beta");
     params.evaporation = config_double(values, "evaporation");
     params.two_opt = config_bool(values, "two_opt");
+    params.candidates = parse_candidate_kind(config_text(values, "candidates", "nearest"));
+    params.local_search = parse_local_search(config_text(values, "local_search", "two_opt"));
 
     return params;
 }
@@ -180,7 +299,11 @@ std::string describe(const SaParams& params) {
     text << std::setprecision(10);
 
     text << "start_temp=" << params.start_temp << ";end_temp=" << params.end_temp
-         << ";cooling=" << params.cooling << ";two_opt=" << bool_text(params.two_opt);
+         << ";cooling=" << params.cooling << ";two_opt=" << bool_text(params.two_opt)
+         << ";candidates=" << candidate_kind_text(params.candidates)
+         << ";local_search=" << local_search_text(params.local_search) << ";moves=" << sa_moves_text(params.moves)
+         << ";schedule=" << sa_schedule_text(params.schedule) << ";reheats=" << params.reheats
+         << ";replicas=" << params.replicas;
 
     return text.str();
 }
@@ -190,7 +313,8 @@ std::string describe(const GaParams& params) {
     text << std::setprecision(10);
 
     text << "population=" << params.population << ";mutation=" << params.mutation
-         << ";two_opt=" << bool_text(params.two_opt);
+         << ";two_opt=" << bool_text(params.two_opt) << ";candidates=" << candidate_kind_text(params.candidates)
+         << ";local_search=" << local_search_text(params.local_search);
 
     return text.str();
 }
@@ -200,7 +324,9 @@ std::string describe(const AcoParams& params) {
     text << std::setprecision(10);
 
     text << "ants=" << params.ants << ";alpha=" << params.alpha << ";beta=" << params.beta
-         << ";evaporation=" << params.evaporation << ";two_opt=" << bool_text(params.two_opt);
+         << ";evaporation=" << params.evaporation << ";two_opt=" << bool_text(params.two_opt)
+         << ";candidates=" << candidate_kind_text(params.candidates)
+         << ";local_search=" << local_search_text(params.local_search);
 
     return text.str();
 }
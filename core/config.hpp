@@ -7,17 +7,62 @@
 #include <string>
 
 
+// Candidate neighbor lists used by local search and ant construction.
+enum class CandidateKind {
+    Nearest,
+    Quadrant,
+    Alpha,
+    Delaunay
+};
+
+// Moves a simulated annealing chain proposes.
+enum class SaMoves {
+    // Reversal of a uniformly random segment; long, so mostly rejected on large instances.
+    Segment,
+    // 2-opt and Or-opt moves that add an edge from a random city to one of its candidates.
+    Neighbor
+};
+
+// How a simulated annealing chain cools.
+enum class SaSchedule {
+    // Geometric cooling from start_temp to end_temp by the cooling factor.
+    Fixed,
+    // Temperatures calibrated from sampled move deltas; under a time limit the cooling factor is
+    // re-derived from the remaining time and measured moves per second.
+    Adaptive
+};
+
+// Moves tried by the local search that two_opt switches on.
+enum class LocalSearch {
+    TwoOpt,
+    // 2-opt plus Or-opt segment moves.
+    OrOpt,
+    // Lin-Kernighan style moves of up to five flips, plus Or-opt.
+    LinKernighan
+};
+
 struct SaParams {
     double start_temp = 10000.0;
     double end_temp = 1e-3;
     double cooling = 0.9999;
     bool two_opt = false;
+    CandidateKind candidates = CandidateKind::Nearest;
+    LocalSearch local_search = LocalSearch::TwoOpt;
+    SaMoves moves = SaMoves::Neighbor;
+    SaSchedule schedule = SaSchedule::Fixed;
+    // Restarts after the first chain that reheat the best tour instead of shuffling a new one.
+    int reheats = 0;
+    // Replicas of each chain run by parallel tempering, one thread each; 1 runs a single chain and 0
+    // one replica per hardware thread.
+    int replicas = 1;
 };
 
 struct GaParams {
     int population = 100;
     double mutation = 0.1;
     bool two_opt = true;
+    CandidateKind candidates = CandidateKind::Nearest;
+    LocalSearch local_search = LocalSearch::TwoOpt;
 };
 
 struct AcoParams {
@@ -26,6 +71,8 @@ struct AcoParams {
     double beta = 5.0;
     double evaporation = 0.3;
     bool two_opt = true;
+    CandidateKind candidates = CandidateKind::Nearest;
+    LocalSearch local_search = LocalSearch::TwoOpt;
 };
 
 std::filesystem::path project_root();
@@ -44,6 +91,16 @@ int parse_int(const std::string& text);
 double config_double(const ConfigMap& values, const std::string& key);
 int config_int(const ConfigMap& values, const std::string& key);
 bool config_bool(const ConfigMap& values, const std::string& key);
+std::string config_text(const ConfigMap& values, const std::string& key, const std::string& fallback);
+
+CandidateKind parse_candidate_kind(const std::string& text);
+std::string candidate_kind_text(CandidateKind kind);
+LocalSearch parse_local_search(const std::string& text);
+std::string local_search_text(LocalSearch kind);
+SaMoves parse_sa_moves(const std::string& text);
+std::string sa_moves_text(SaMoves moves);
+SaSchedule parse_sa_schedule(const std::string& text);
+std::string sa_schedule_text(SaSchedule schedule);
 
 SaParams sa_params_from(const ConfigMap& values);
 GaParams ga_params_from(const ConfigMap& values);
@@ -0,0 +1,37 @@
+#ifndef TSP_CORE_COORDINATE_DISTANCE
+#define TSP_CORE_COORDINATE_DISTANCE
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Matrix-free distance provider: city coordinates in structure-of-arrays form indexed by
+// city id - 1, with the rounded EUC_2D distance computed on every lookup. O(n) memory.
+class CoordinateDistance {
+public:
+    using value_type = std::int32_t;
+
+    CoordinateDistance() = default;
+    CoordinateDistance(std::vector<double> x, std::vector<double> y) : x_(std::move(x)), y_(std::move(y)) {}
+
+    std::size_t size() const { return x_.size(); }
+    std::size_t bytes() const { return (x_.size() + y_.size()) * sizeof(double); }
+
+    std::int32_t operator()(std::size_t i, std::size_t j) const {
+        const double dx = x_[i] - x_[j];
+        const double dy = y_[i] - y_[j];
+
+        return static_cast<std::int32_t>(std::floor(std::sqrt(dx * dx + dy * dy) + 0.5));
+    }
+
+    const std::vector<double>& x() const { return x_; }
+    const std::vector<double>& y() const { return y_; }
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+};
+
+#endif
@@ -0,0 +1,421 @@
+#include "delaunay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Snapped coordinates stay below 2^26, keeping every incircle determinant under 2^110.
+constexpr double GRID = 67108863.0;
+constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+__extension__ typedef __int128 Wide;
+
+struct Point {
+    std::int64_t x;
+    std::int64_t y;
+
+    bool operator==(const Point& other) const { return x == other.x && y == other.y; }
+};
+
+// Positive when c lies left of the directed line a -> b.
+std::int64_t orient(const Point& a, const Point& b, const Point& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// True when d lies strictly inside the circumcircle of the counter-clockwise triangle (a, b, c).
+bool in_circle(const Point& a, const Point& b, const Point& c, const Point& d) {
+    const std::int64_t adx = a.x - d.x;
+    const std::int64_t ady = a.y - d.y;
+    const std::int64_t bdx = b.x - d.x;
+    const std::int64_t bdy = b.y - d.y;
+    const std::int64_t cdx = c.x - d.x;
+    const std::int64_t cdy = c.y - d.y;
+
+    const Wide ad = Wide(adx) * adx + Wide(ady) * ady;
+    const Wide bd = Wide(bdx) * bdx + Wide(bdy) * bdy;
+    const Wide cd = Wide(cdx) * cdx + Wide(cdy) * cdy;
+
+    const Wide det = adx * (bdy * cd - bd * cdy) - ady * (bdx * cd - bd * cdx) + ad * (Wide(bdx) * cdy - Wide(bdy) * cdx);
+    return det > 0;
+}
+
+double squared_distance(const Point& a, double x, double y) {
+    const double dx = static_cast<double>(a.x) - x;
+    const double dy = static_cast<double>(a.y) - y;
+
+    return dx * dx + dy * dy;
+}
+
+// Circumcenter offset of (a, b, c) from a; infinite for collinear points.
+std::pair<double, double> circumcenter_offset(const Point& a, const Point& b, const Point& c) {
+    const double dx = static_cast<double>(b.x - a.x);
+    const double dy = static_cast<double>(b.y - a.y);
+    const double ex = static_cast<double>(c.x - a.x);
+    const double ey = static_cast<double>(c.y - a.y);
+    const double bl = dx * dx + dy * dy;
+    const double cl = ex * ex + ey * ey;
+    const double d = 0.5 / (dx * ey - dy * ex);
+
+    return {(ey * bl - dy * cl) * d, (dx * cl - ex * bl) * d};
+}
+
+// Monotone in the angle of (dx, dy), counter-clockwise, mapped to [0, 1).
+double pseudo_angle(double dx, double dy) {
+    const double sum = std::fabs(dx) + std::fabs(dy);
+    if (sum == 0.0) {
+        return 0.0;
+    }
+
+    const double p = dx / sum;
+    return (dy > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+}
+
+// Triangles are counter-clockwise vertex triples; halfedge e runs from triangles_[e] to the next
+// vertex of its triangle, and halfedges_[e] is its twin (NONE on the convex hull). The hull is a
+// counter-clockwise linked list whose edge starting at city i is halfedge hull_tri_[i].
+class Triangulator {
+public:
+    explicit Triangulator(std::vector<Point> points) : points_(std::move(points)) {}
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> edges();
+
+private:
+    std::uint32_t add_triangle(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t ab, std::uint32_t bc,
+                               std::uint32_t ca);
+    void link(std::uint32_t a, std::uint32_t b);
+    std::uint32_t legalize(std::uint32_t a);
+    std::size_t hash_key(const Point& p) const;
+    bool triangulate();
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> collinear_path() const;
+
+    std::vector<Point> points_;
+    std::vector<std::uint32_t> triangles_;
+    std::vector<std::uint32_t> halfedges_;
+    std::vector<std::uint32_t> hull_prev_;
+    std::vector<std::uint32_t> hull_next_;
+    std::vector<std::uint32_t> hull_tri_;
+    std::vector<std::uint32_t> hull_hash_;
+    std::vector<std::uint32_t> flip_stack_;
+    std::uint32_t hull_start_ = 0;
+    double center_x_ = 0.0;
+    double center_y_ = 0.0;
+};
+
+std::uint32_t Triangulator::add_triangle(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t ab,
+                                         std::uint32_t bc, std::uint32_t ca) {
+    const auto t = static_cast<std::uint32_t>(triangles_.size());
+
+    triangles_.insert(triangles_.end(), {a, b, c});
+    halfedges_.insert(halfedges_.end(), {NONE, NONE, NONE});
+    link(t, ab);
+    link(t + 1, bc);
+    link(t + 2, ca);
+    return t;
+}
+
+void Triangulator::link(std::uint32_t a, std::uint32_t b) {
+    halfedges_[a] = b;
+    if (b != NONE) {
+        halfedges_[b] = a;
+    }
+}
+
+// Flips halfedge a and every edge it exposes until all are locally Delaunay. Returns the
+// halfedge that now leaves the inserted point along the hull edge checked first.
+std::uint32_t Triangulator::legalize(std::uint32_t a) {
+    std::uint32_t ar = 0;
+
+    while (true) {
+        const std::uint32_t b = halfedges_[a];
+        const std::uint32_t a0 = a - a % 3;
+        ar = a0 + (a + 2) % 3;
+
+        if (b == NONE) {
+            if (flip_stack_.empty()) {
+                break;
+            }
+            a = flip_stack_.back();
+            flip_stack_.pop_back();
+            continue;
+        }
+
+        const std::uint32_t b0 = b - b % 3;
+        const std::uint32_t al = a0 + (a + 1) % 3;
+        const std::uint32_t bl = b0 + (b + 2) % 3;
+
+        const std::uint32_t p0 = triangles_[ar];
+        const std::uint32_t pr = triangles_[a];
+        const std::uint32_t pl = triangles_[al];
+        const std::uint32_t p1 = triangles_[bl];
+
+        if (!in_circle(points_[p0], points_[pr], points_[pl], points_[p1])) {
+            if (flip_stack_.empty()) {
+                break;
+            }
+            a = flip_stack_.back();
+            flip_stack_.pop_back();
+            continue;
+        }
+
+        triangles_[a] = p1;
+        triangles_[b] = p0;
+
+        const std::uint32_t hbl = halfedges_[bl];
+
+        // The flipped-away edge was on the hull: repoint the hull entry that referenced it.
+        if (hbl == NONE) {
+            std::uint32_t e = hull_start_;
+            do {
+                if (hull_tri_[e] == bl) {
+                    hull_tri_[e] = a;
+                    break;
+                }
+                e = hull_prev_[e];
+            } while (e != hull_start_);
+        }
+        link(a, hbl);
+        link(b, halfedges_[ar]);
+        link(ar, bl);
+
+        flip_stack_.push_back(b0 + (b + 1) % 3);
+    }
+
+    return ar;
+}
+
+std::size_t Triangulator::hash_key(const Point& p) const {
+    const double angle = pseudo_angle(static_cast<double>(p.x) - center_x_, static_cast<double>(p.y) - center_y_);
+
+    return static_cast<std::size_t>(std::floor(angle * static_cast<double>(hull_hash_.size()))) % hull_hash_.size();
+}
+
+bool Triangulator::triangulate() {
+    const std::size_t n = points_.size();
+
+    double min_x = std::numeric_limits<double>::infinity();
+    double min_y = min_x;
+    double max_x = -min_x;
+    double max_y = -min_x;
+    for (const Point& p: points_) {
+        min_x = std::min(min_x, static_cast<double>(p.x));
+        min_y = std::min(min_y, static_cast<double>(p.y));
+        max_x = std::max(max_x, static_cast<double>(p.x));
+        max_y = std::max(max_y, static_cast<double>(p.y));
+    }
+
+    // Seed: the city nearest the box center, its nearest distinct city, and the third city
+    // giving the smallest circumcircle.
+    auto nearest_to = [&](double x, double y, auto skip) {
+        std::uint32_t best = NONE;
+        double best_distance = std::numeric_limits<double>::infinity();
+        for (std::uint32_t i = 0; i < n; ++i) {
+            const double d = squared_distance(points_[i], x, y);
+            if (d < best_distance && !skip(i)) {
+                best = i;
+                best_distance = d;
+            }
+        }
+        return best;
+    };
+
+    const std::uint32_t i0 = nearest_to((min_x + max_x) / 2.0, (min_y + max_y) / 2.0, [](std::uint32_t) { return false; });
+    const Point seed = points_[i0];
+    const std::uint32_t i1 = nearest_to(static_cast<double>(seed.x), static_cast<double>(seed.y),
+                                        [&](std::uint32_t i) { return points_[i] == seed; });
+    if (i1 == NONE) {
+        return false;
+    }
+
+    std::uint32_t i2 = NONE;
+    double min_radius = std::numeric_limits<double>::infinity();
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (orient(seed, points_[i1], points_[i]) == 0) {
+            continue;
+        }
+        const auto [ox, oy] = circumcenter_offset(seed, points_[i1], points_[i]);
+        const double radius = ox * ox + oy * oy;
+        if (radius < min_radius) {
+            i2 = i;
+            min_radius = radius;
+        }
+    }
+    if (i2 == NONE) {
+        return false;
+    }
+
+    std::uint32_t a = i0;
+    std::uint32_t b = i1;
+    std::uint32_t c = i2;
+    if (orient(points_[a], points_[b], points_[c]) < 0) {
+        std::swap(b, c);
+    }
+
+    const auto [ox, oy] = circumcenter_offset(points_[a], points_[b], points_[c]);
+    center_x_ = static_cast<double>(points_[a].x) + ox;
+    center_y_ = static_cast<double>(points_[a].y) + oy;
+
+    // Insertion in order of distance from the seed circle keeps every new city outside the hull;
+    // ties break on coordinates so coincident cities end up adjacent.
+    std::vector<double> distance(n);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        distance[i] = squared_distance(points_[i], center_x_, center_y_);
+    }
+    std::vector<std::uint32_t> ids(n);
+    std::iota(ids.begin(), ids.end(), std::uint32_t{0});
+    std::sort(ids.begin(), ids.end(), [&](std::uint32_t x, std::uint32_t y) {
+        if (distance[x] != distance[y]) {
+            return distance[x] < distance[y];
+        }
+        if (points_[x].x != points_[y].x) {
+            return points_[x].x < points_[y].x;
+        }
+        if (points_[x].y != points_[y].y) {
+            return points_[x].y < points_[y].y;
+        }
+        return x < y;
+    });
+
+    hull_prev_.assign(n, 0);
+    hull_next_.assign(n, 0);
+    hull_tri_.assign(n, 0);
+    hull_hash_.assign(static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(n)))), NONE);
+    triangles_.reserve(6 * n);
+    halfedges_.reserve(6 * n);
+
+    hull_start_ = a;
+    hull_next_[a] = hull_prev_[c] = b;
+    hull_next_[b] = hull_prev_[a] = c;
+    hull_next_[c] = hull_prev_[b] = a;
+    hull_tri_[a] = 0;
+    hull_tri_[b] = 1;
+    hull_tri_[c] = 2;
+    hull_hash_[hash_key(points_[a])] = a;
+    hull_hash_[hash_key(points_[b])] = b;
+    hull_hash_[hash_key(points_[c])] = c;
+    add_triangle(a, b, c, NONE, NONE, NONE);
+
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::uint32_t i = ids[k];
+        const Point& p = points_[i];
+
+        if (i == a || i == b || i == c || (k > 0 && p == points_[ids[k - 1]]) || p == points_[a] ||
+            p == points_[b] || p == points_[c]) {
+            continue;
+        }
+
+        const std::size_t key = hash_key(p);
+        std::uint32_t start = 0;
+        for (std::size_t j = 0; j < hull_hash_.size(); ++j) {
+            start = hull_hash_[(key + j) % hull_hash_.size()];
+            if (start != NONE && start != hull_next_[start]) {
+                break;
+            }
+        }
+
+        // Walk the hull to the first edge that sees p from outside.
+        start = hull_prev_[start];
+        std::uint32_t e = start;
+        while (orient(points_[e], points_[hull_next_[e]], p) >= 0) {
+            e = hull_next_[e];
+            if (e == start) {
+                e = NONE;
+                break;
+            }
+        }
+        if (e == NONE) {
+            continue;
+        }
+
+        std::uint32_t t = add_triangle(e, i, hull_next_[e], NONE, NONE, hull_tri_[e]);
+        hull_tri_[i] = legalize(t + 2);
+        hull_tri_[e] = t;
+
+        std::uint32_t next = hull_next_[e];
+        for (std::uint32_t q = hull_next_[next]; orient(points_[next], points_[q], p) < 0; q = hull_next_[next]) {
+            t = add_triangle(next, i, q, hull_tri_[i], NONE, hull_tri_[next]);
+            hull_tri_[i] = legalize(t + 2);
+            hull_next_[next] = next;
+            next = q;
+        }
+
+        if (e == start) {
+            for (std::uint32_t q = hull_prev_[e]; orient(points_[q], points_[e], p) < 0; q = hull_prev_[e]) {
+                t = add_triangle(q, i, e, NONE, hull_tri_[e], hull_tri_[q]);
+                legalize(t + 2);
+                hull_tri_[q] = t;
+                hull_next_[e] = e;
+                e = q;
+            }
+        }
+
+        hull_start_ = hull_prev_[i] = e;
+        hull_next_[e] = hull_prev_[next] = i;
+        hull_next_[i] = next;
+        hull_hash_[key] = i;
+        hull_hash_[hash_key(points_[e])] = e;
+    }
+
+    return true;
+}
+
+std::vector<std::pair<std::uint32_t, std::uint32_t>> Triangulator::collinear_path() const {
+    std::vector<std::uint32_t> ids(points_.size());
+    std::iota(ids.begin(), ids.end(), std::uint32_t{0});
+    std::sort(ids.begin(), ids.end(), [&](std::uint32_t x, std::uint32_t y) {
+        return points_[x].x != points_[y].x ? points_[x].x < points_[y].x : points_[x].y < points_[y].y;
+    });
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+    std::uint32_t previous = ids.empty() ? NONE : ids[0];
+    for (std::size_t k = 1; k < ids.size(); ++k) {
+        if (points_[ids[k]] == points_[previous]) {
+            continue;
+        }
+        edges.emplace_back(std::min(previous, ids[k]), std::max(previous, ids[k]));
+        previous = ids[k];
+    }
+    return edges;
+}
+
+std::vector<std::pair<std::uint32_t, std::uint32_t>> Triangulator::edges() {
+    if (!triangulate()) {
+        return collinear_path();
+    }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> result;
+    result.reserve(triangles_.size() / 2 + points_.size());
+    for (std::uint32_t e = 0; e < triangles_.size(); ++e) {
+        const std::uint32_t twin = halfedges_[e];
+        if (twin == NONE || e < twin) {
+            const std::uint32_t from = triangles_[e];
+            const std::uint32_t to = triangles_[e % 3 == 2 ? e - 2 : e + 1];
+            result.emplace_back(std::min(from, to), std::max(from, to));
+        }
+    }
+    return result;
+}
+
+}
+
+std::vector<std::pair<std::uint32_t, std::uint32_t>> delaunay_edges(const CoordinateDistance& coordinates) {
+    const std::size_t n = coordinates.size();
+
+    if (n < 2) {
+        return {};
+    }
+
+    const auto [min_x, max_x] = std::minmax_element(coordinates.x().begin(), coordinates.x().end());
+    const auto [min_y, max_y] = std::minmax_element(coordinates.y().begin(), coordinates.y().end());
+    const double extent = std::max(*max_x - *min_x, *max_y - *min_y);
+    const double scale = extent > 0.0 ? GRID / extent : 0.0;
+
+    std::vector<Point> points(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        points[i] = {std::llround((coordinates.x()[i] - *min_x) * scale), std::llround((coordinates.y()[i] - *min_y) * scale)};
+    }
+
+    return Triangulator(std::move(points)).edges();
+}
@@ -0,0 +1,17 @@
+#ifndef TSP_CORE_DELAUNAY
+#define TSP_CORE_DELAUNAY
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "coordinate_distance.hpp"
+
+// Edges (a < b) of the Delaunay triangulation of the cities, built in O(n log n) with a
+// sweep-hull insertion and Lawson flips. Predicates run exactly on coordinates snapped to a
+// 2^26 grid, so grids and cocircular points (pla*, rl*) triangulate consistently.
+// Cities that coincide with an earlier one after snapping get no edges; callers attach them.
+// Collinear input yields the path through the sorted points.
+std::vector<std::pair<std::uint32_t, std::uint32_t>> delaunay_edges(const CoordinateDistance& coordinates);
+
+#endif
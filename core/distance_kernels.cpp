@@ -0,0 +1,296 @@
+#include "distance_kernels.hpp"
+
+#include <cmath>
+
+#include "triangular_matrix.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TSP_X86_KERNELS 1
+#endif
+
+namespace {
+
+using Kernel = void (*)(const double*, const double*, double, double, std::size_t, std::int32_t*);
+
+// Distances are non-negative, so truncating sqrt + 0.5 equals the floor used by tsplib_distance.
+void scalar_distances(const double* x, const double* y, double px, double py, std::size_t count,
+                      std::int32_t* out) {
+    for (std::size_t j = 0; j < count; ++j) {
+        const double dx = px - x[j];
+        const double dy = py - y[j];
+
+        out[j] = static_cast<std::int32_t>(std::sqrt(dx * dx + dy * dy) + 0.5);
+    }
+}
+
+#ifdef TSP_X86_KERNELS
+
+void sse2_distances(const double* x, const double* y, double px, double py, std::size_t count,
+                    std::int32_t* out) {
+    const __m128d vx = _mm_set1_pd(px);
+    const __m128d vy = _mm_set1_pd(py);
+    const __m128d half = _mm_set1_pd(0.5);
+
+    std::size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        const __m128d dx = _mm_sub_pd(vx, _mm_loadu_pd(x + j));
+        const __m128d dy = _mm_sub_pd(vy, _mm_loadu_pd(y + j));
+        const __m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_cvttpd_epi32(_mm_add_pd(length, half)));
+    }
+
+    scalar_distances(x + j, y + j, px, py, count - j, out + j);
+}
+
+// No FMA in the target list: a fused multiply-add would round differently from the scalar code.
+__attribute__((target("avx2"))) void avx2_distances(const double* x, const double* y, double px, double py,
+                                                    std::size_t count, std::int32_t* out) {
+    const __m256d vx = _mm256_set1_pd(px);
+    const __m256d vy = _mm256_set1_pd(py);
+    const __m256d half = _mm256_set1_pd(0.5);
+
+    std::size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        const __m256d dx0 = _mm256_sub_pd(vx, _mm256_loadu_pd(x + j));
+        const __m256d dy0 = _mm256_sub_pd(vy, _mm256_loadu_pd(y + j));
+        const __m256d dx1 = _mm256_sub_pd(vx, _mm256_loadu_pd(x + j + 4));
+        const __m256d dy1 = _mm256_sub_pd(vy, _mm256_loadu_pd(y + j + 4));
+        const __m256d length0 = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx0, dx0), _mm256_mul_pd(dy0, dy0)));
+        const __m256d length1 = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx1, dx1), _mm256_mul_pd(dy1, dy1)));
+        const __m128i rounded0 = _mm256_cvttpd_epi32(_mm256_add_pd(length0, half));
+        const __m128i rounded1 = _mm256_cvttpd_epi32(_mm256_add_pd(length1, half));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), _mm256_set_m128i(rounded1, rounded0));
+    }
+
+    sse2_distances(x + j, y + j, px, py, count - j, out + j);
+}
+
+#endif
+
+Kernel select_kernel() {
+#ifdef TSP_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2_distances;
+    }
+    return sse2_distances;
+#else
+    return scalar_distances;
+#endif
+}
+
+const Kernel kernel = select_kernel();
+
+template <typename T>
+using DeltaKernel = void (*)(const T*, std::size_t, const std::uint32_t*, const std::uint32_t*, const std::uint32_t*,
+                             const std::uint32_t*, std::int64_t*);
+
+template <typename T>
+void scalar_reversal_deltas(const T* matrix, std::size_t n, const std::uint32_t* a, const std::uint32_t* b,
+                            const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    auto at = [&](std::size_t i, std::size_t j) { return std::int64_t{matrix[i * n + j]}; };
+
+    for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+        out[k] = at(a[k], c[k]) + at(b[k], d[k]) - at(a[k], b[k]) - at(c[k], d[k]);
+    }
+}
+
+template <typename T>
+void scalar_packed_reversal_deltas(const T* matrix, std::size_t, const std::uint32_t* a, const std::uint32_t* b,
+                                   const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    auto at = [&](std::size_t i, std::size_t j) { return std::int64_t{matrix[TriangularMatrix<T>::index(i, j)]}; };
+
+    for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+        out[k] = at(a[k], c[k]) + at(b[k], d[k]) - at(a[k], b[k]) - at(c[k], d[k]);
+    }
+}
+
+#ifdef TSP_X86_KERNELS
+
+// Row-major index i * n + j of a dense matrix.
+__attribute__((target("avx2"))) inline __m256i dense_index(__m256i i, __m256i j, __m256i n) {
+    return _mm256_add_epi32(_mm256_mullo_epi32(i, n), j);
+}
+
+// Packed-triangle index high * (high + 1) / 2 + low. The product is formed modulo 2^32 and
+// shifted logically, which is exact while high + 1 fits in 16 bits.
+__attribute__((target("avx2"))) inline __m256i packed_index(__m256i i, __m256i j) {
+    const __m256i low = _mm256_min_epu32(i, j);
+    const __m256i high = _mm256_max_epu32(i, j);
+    const __m256i column = _mm256_srli_epi32(_mm256_mullo_epi32(high, _mm256_add_epi32(high, _mm256_set1_epi32(1))), 1);
+
+    return _mm256_add_epi32(column, low);
+}
+
+// Sums are widened to 64 bits before subtracting, as int32 distances may take up to 31 bits.
+__attribute__((target("avx2"))) inline void store_int32_deltas(__m256i ac, __m256i bd, __m256i ab, __m256i cd,
+                                                               std::int64_t* out) {
+    const __m256i added_low = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(ac)),
+                                                _mm256_cvtepi32_epi64(_mm256_castsi256_si128(bd)));
+    const __m256i removed_low = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(ab)),
+                                                  _mm256_cvtepi32_epi64(_mm256_castsi256_si128(cd)));
+    const __m256i added_high = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(ac, 1)),
+                                                 _mm256_cvtepi32_epi64(_mm256_extracti128_si256(bd, 1)));
+    const __m256i removed_high = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(ab, 1)),
+                                                   _mm256_cvtepi32_epi64(_mm256_extracti128_si256(cd, 1)));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_sub_epi64(added_low, removed_low));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4), _mm256_sub_epi64(added_high, removed_high));
+}
+
+// uint16 entries are gathered as the 4 bytes at each entry with the high half masked off; their
+// sums cannot overflow 32 bits.
+__attribute__((target("avx2"))) inline void store_uint16_deltas(__m256i ac, __m256i bd, __m256i ab, __m256i cd,
+                                                                std::int64_t* out) {
+    const __m256i low = _mm256_set1_epi32(0xFFFF);
+    const __m256i added = _mm256_add_epi32(_mm256_and_si256(ac, low), _mm256_and_si256(bd, low));
+    const __m256i removed = _mm256_add_epi32(_mm256_and_si256(ab, low), _mm256_and_si256(cd, low));
+    const __m256i delta = _mm256_sub_epi32(added, removed);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepi32_epi64(_mm256_castsi256_si128(delta)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4),
+                        _mm256_cvtepi32_epi64(_mm256_extracti128_si256(delta, 1)));
+}
+
+__attribute__((target("avx2"))) void avx2_reversal_deltas(const std::int32_t* matrix, std::size_t n,
+                                                          const std::uint32_t* a, const std::uint32_t* b,
+                                                          const std::uint32_t* c, const std::uint32_t* d,
+                                                          std::int64_t* out) {
+    const __m256i vn = _mm256_set1_epi32(static_cast<int>(n));
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+    const __m256i vd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+    const auto* base = reinterpret_cast<const int*>(matrix);
+
+    store_int32_deltas(_mm256_i32gather_epi32(base, dense_index(va, vc, vn), 4),
+                       _mm256_i32gather_epi32(base, dense_index(vb, vd, vn), 4),
+                       _mm256_i32gather_epi32(base, dense_index(va, vb, vn), 4),
+                       _mm256_i32gather_epi32(base, dense_index(vc, vd, vn), 4), out);
+}
+
+__attribute__((target("avx2"))) void avx2_reversal_deltas(const std::uint16_t* matrix, std::size_t n,
+                                                          const std::uint32_t* a, const std::uint32_t* b,
+                                                          const std::uint32_t* c, const std::uint32_t* d,
+                                                          std::int64_t* out) {
+    const __m256i vn = _mm256_set1_epi32(static_cast<int>(n));
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+    const __m256i vd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+    const auto* base = reinterpret_cast<const int*>(matrix);
+
+    store_uint16_deltas(_mm256_i32gather_epi32(base, dense_index(va, vc, vn), 2),
+                        _mm256_i32gather_epi32(base, dense_index(vb, vd, vn), 2),
+                        _mm256_i32gather_epi32(base, dense_index(va, vb, vn), 2),
+                        _mm256_i32gather_epi32(base, dense_index(vc, vd, vn), 2), out);
+}
+
+__attribute__((target("avx2"))) void avx2_packed_reversal_deltas(const std::int32_t* matrix, std::size_t,
+                                                                 const std::uint32_t* a, const std::uint32_t* b,
+                                                                 const std::uint32_t* c, const std::uint32_t* d,
+                                                                 std::int64_t* out) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+    const __m256i vd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+    const auto* base = reinterpret_cast<const int*>(matrix);
+
+    store_int32_deltas(_mm256_i32gather_epi32(base, packed_index(va, vc), 4),
+                       _mm256_i32gather_epi32(base, packed_index(vb, vd), 4),
+                       _mm256_i32gather_epi32(base, packed_index(va, vb), 4),
+                       _mm256_i32gather_epi32(base, packed_index(vc, vd), 4), out);
+}
+
+__attribute__((target("avx2"))) void avx2_packed_reversal_deltas(const std::uint16_t* matrix, std::size_t,
+                                                                 const std::uint32_t* a, const std::uint32_t* b,
+                                                                 const std::uint32_t* c, const std::uint32_t* d,
+                                                                 std::int64_t* out) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+    const __m256i vd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+    const auto* base = reinterpret_cast<const int*>(matrix);
+
+    store_uint16_deltas(_mm256_i32gather_epi32(base, packed_index(va, vc), 2),
+                        _mm256_i32gather_epi32(base, packed_index(vb, vd), 2),
+                        _mm256_i32gather_epi32(base, packed_index(va, vb), 2),
+                        _mm256_i32gather_epi32(base, packed_index(vc, vd), 2), out);
+}
+
+#endif
+
+template <typename T>
+DeltaKernel<T> select_delta_kernel(bool packed) {
+#ifdef TSP_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return packed ? static_cast<DeltaKernel<T>>(avx2_packed_reversal_deltas)
+                      : static_cast<DeltaKernel<T>>(avx2_reversal_deltas);
+    }
+#endif
+    return packed ? scalar_packed_reversal_deltas<T> : scalar_reversal_deltas<T>;
+}
+
+const DeltaKernel<std::int32_t> int32_delta_kernel = select_delta_kernel<std::int32_t>(false);
+const DeltaKernel<std::uint16_t> uint16_delta_kernel = select_delta_kernel<std::uint16_t>(false);
+const DeltaKernel<std::int32_t> int32_packed_delta_kernel = select_delta_kernel<std::int32_t>(true);
+const DeltaKernel<std::uint16_t> uint16_packed_delta_kernel = select_delta_kernel<std::uint16_t>(true);
+
+// Gather indices are 32-bit, so larger matrices take the scalar loop: 46340 is the largest n with
+// n * n below 2^31.
+bool gather_indexable(std::size_t n) {
+    return n <= 46340;
+}
+
+// The packed index's product high * (high + 1) must fit in 32 bits unsigned; its half then stays
+// below 2^31.
+bool packed_gather_indexable(std::size_t n) {
+    return n <= 65535;
+}
+
+}
+
+void euc2d_distances(const double* x, const double* y, double px, double py, std::size_t count,
+                     std::int32_t* out) {
+    kernel(x, y, px, py, count, out);
+}
+
+void reversal_deltas(const std::int32_t* matrix, std::size_t n, const std::uint32_t* a, const std::uint32_t* b,
+                     const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    (gather_indexable(n) ? int32_delta_kernel : scalar_reversal_deltas<std::int32_t>)(matrix, n, a, b, c, d, out);
+}
+
+void reversal_deltas(const std::uint16_t* matrix, std::size_t n, const std::uint32_t* a, const std::uint32_t* b,
+                     const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out) {
+    (gather_indexable(n) ? uint16_delta_kernel : scalar_reversal_deltas<std::uint16_t>)(matrix, n, a, b, c, d, out);
+}
+
+void packed_reversal_deltas(const std::int32_t* matrix, std::size_t n, const std::uint32_t* a,
+                            const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d,
+                            std::int64_t* out) {
+    (packed_gather_indexable(n) ? int32_packed_delta_kernel
+                                : scalar_packed_reversal_deltas<std::int32_t>)(matrix, n, a, b, c, d, out);
+}
+
+void packed_reversal_deltas(const std::uint16_t* matrix, std::size_t n, const std::uint32_t* a,
+                            const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d,
+                            std::int64_t* out) {
+    (packed_gather_indexable(n) ? uint16_packed_delta_kernel
+                                : scalar_packed_reversal_deltas<std::uint16_t>)(matrix, n, a, b, c, d, out);
+}
+
+const char* euc2d_kernel_name() {
+#ifdef TSP_X86_KERNELS
+    if (kernel == avx2_distances) {
+        return "avx2";
+    }
+    if (kernel == sse2_distances) {
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
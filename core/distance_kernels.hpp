@@ -0,0 +1,38 @@
+#ifndef TSP_CORE_DISTANCE_KERNELS
+#define TSP_CORE_DISTANCE_KERNELS
+
+#include <cstddef>
+#include <cstdint>
+
+// Rounded EUC_2D distances from (px, py) to the count cities stored in SoA arrays x and y,
+// written to out. Uses AVX2 or SSE2 when the CPU has them and matches CoordinateDistance
+// bit for bit: the vector code performs the same IEEE operations in the same order.
+void euc2d_distances(const double* x, const double* y, double px, double py, std::size_t count,
+                     std::int32_t* out);
+
+// Name of the instruction set euc2d_distances dispatches to ("avx2", "sse2" or "scalar").
+const char* euc2d_kernel_name();
+
+// Proposals reversal_deltas evaluates per call.
+inline constexpr std::size_t DELTA_LANES = 8;
+
+// For each of DELTA_LANES 2-opt moves with cities a[k], b[k], c[k], d[k], writes
+// m(a, c) + m(b, d) - m(a, b) - m(c, d) to out[k], reading the dense row-major n x n matrix m.
+// Uses AVX2 gathers when the CPU has them. Diagonal entries must not be read: the uint16 gather
+// loads the 4 bytes at each entry, and the last one is the matrix's final diagonal entry.
+void reversal_deltas(const std::int32_t* matrix, std::size_t n, const std::uint32_t* a, const std::uint32_t* b,
+                     const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out);
+void reversal_deltas(const std::uint16_t* matrix, std::size_t n, const std::uint32_t* a, const std::uint32_t* b,
+                     const std::uint32_t* c, const std::uint32_t* d, std::int64_t* out);
+
+// The same over the packed upper triangle of a TriangularMatrix, entry (i, j) at
+// max * (max + 1) / 2 + min. The gather indices are computed in vector registers; the diagonal
+// rule is the same, and with it the uint16 gather never reads past the last off-diagonal entry.
+void packed_reversal_deltas(const std::int32_t* matrix, std::size_t n, const std::uint32_t* a,
+                            const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d,
+                            std::int64_t* out);
+void packed_reversal_deltas(const std::uint16_t* matrix, std::size_t n, const std::uint32_t* a,
+                            const std::uint32_t* b, const std::uint32_t* c, const std::uint32_t* d,
+                            std::int64_t* out);
+
+#endif
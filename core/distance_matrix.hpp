@@ -0,0 +1,32 @@
+#ifndef TSP_CORE_DISTANCE_MATRIX
+#define TSP_CORE_DISTANCE_MATRIX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dense row-major n x n matrix of rounded EUC_2D distances indexed by city id - 1.
+// T is the storage type: std::int32_t in general, std::uint16_t when every distance fits.
+template <typename T>
+class DistanceMatrix {
+public:
+    using value_type = T;
+
+    DistanceMatrix() = default;
+    explicit DistanceMatrix(std::size_t n) : n_(n), data_(n * n, T{0}) {}
+
+    std::size_t size() const { return n_; }
+    std::size_t bytes() const { return data_.size() * sizeof(T); }
+
+    T operator()(std::size_t i, std::size_t j) const { return data_[i * n_ + j]; }
+    void set(std::size_t i, std::size_t j, T value) { data_[i * n_ + j] = value; }
+
+    const T* row(std::size_t i) const { return data_.data() + i * n_; }
+    T* row(std::size_t i) { return data_.data() + i * n_; }
+
+private:
+    std::size_t n_ = 0;
+    std::vector<T> data_;
+};
+
+#endif
@@ -0,0 +1,310 @@
+#include "instance_cache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'S', 'P', 'B'};
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Fixed 40-byte file header; the coordinate arrays and list sections that follow stay 8-byte
+// aligned, so they can be read in place from the mapping.
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t list_count;
+    std::uint64_t source_hash;
+    std::uint64_t source_size;
+    std::uint64_t cities;
+};
+
+struct ListHeader {
+    std::uint32_t kind;
+    std::uint32_t reserved;
+    std::uint64_t k;
+    std::uint64_t entries;
+};
+
+static_assert(sizeof(FileHeader) == 40, "FileHeader must have no padding");
+static_assert(sizeof(ListHeader) == 24, "ListHeader must have no padding");
+static_assert(sizeof(Neighbor) == 8, "Neighbor entries are stored as raw 8-byte records");
+
+bool files_enabled() {
+    const char* env = std::getenv("TSP_INSTANCE_CACHE");
+    if (env == nullptr || *env == '\0') {
+        return true;
+    }
+
+    const std::string value = env;
+    if (value == "on") {
+        return true;
+    }
+    if (value == "off") {
+        return false;
+    }
+
+    throw std::runtime_error("Invalid TSP_INSTANCE_CACHE: " + value);
+}
+
+std::uint64_t rotate_left(std::uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Reads sizeof(T) bytes at offset into value; false when the file is too short.
+template <typename T>
+bool read_at(std::string_view bytes, std::size_t offset, T& value) {
+    if (offset > bytes.size() || bytes.size() - offset < sizeof(T)) {
+        return false;
+    }
+
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return true;
+}
+
+template <typename T>
+void write_raw(std::ofstream& out, const T* data, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+}
+
+std::uint64_t content_hash(std::string_view bytes) {
+    constexpr std::uint64_t K1 = 0x87C37B91114253D5ULL;
+    constexpr std::uint64_t K2 = 0x4CF5AD432745937FULL;
+
+    std::uint64_t h = 0x9E3779B97F4A7C15ULL ^ bytes.size();
+    std::size_t i = 0;
+
+    for (; i + 8 <= bytes.size(); i += 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, bytes.data() + i, 8);
+        h = rotate_left(h ^ (word * K1), 31) * K2;
+    }
+
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+
+    return mix(h ^ (tail * K1));
+}
+
+std::string binary_instance_path(const std::string& filename) {
+    return std::filesystem::path(filename).replace_extension(".tspb").string();
+}
+
+InstanceCache::InstanceCache(const std::string& filename)
+    : filename_(filename), binary_path_(binary_instance_path(filename)), files_enabled_(files_enabled()) {
+    const MappedFile source(filename);
+    const std::string_view text = source.text();
+
+    source_size_ = text.size();
+    source_hash_ = content_hash(text);
+
+    if (!files_enabled_ || !load_binary(text)) {
+        mapped_lists_.clear();
+        binary_.reset();
+        parse_tsplib(cities_, text, filename);
+        dirty_ = files_enabled_;
+    }
+}
+
+bool InstanceCache::load_binary(std::string_view source) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(binary_path_, error)) {
+        return false;
+    }
+
+    try {
+        binary_ = std::make_unique<MappedFile>(binary_path_);
+    }
+    catch (const std::runtime_error&) {
+        return false;
+    }
+
+    const std::string_view bytes = binary_->text();
+    FileHeader header{};
+    if (!read_at(bytes, 0, header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version != INSTANCE_CACHE_VERSION || header.byte_order != BYTE_ORDER_MARK ||
+        header.source_hash != source_hash_ || header.source_size != source.size() || header.cities == 0 ||
+        header.cities > (bytes.size() - sizeof(FileHeader)) / (2 * sizeof(double))) {
+        return false;
+    }
+
+    const auto n = static_cast<std::size_t>(header.cities);
+    const auto* coordinates = reinterpret_cast<const double*>(bytes.data() + sizeof(FileHeader));
+
+    cities_.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        cities_[i] = City{static_cast<int>(i + 1), {coordinates[i], coordinates[n + i]}};
+    }
+
+    std::size_t offset = sizeof(FileHeader) + 2 * n * sizeof(double);
+    for (std::uint32_t list = 0; list < header.list_count; ++list) {
+        ListHeader list_header{};
+        if (!read_at(bytes, offset, list_header)) {
+            return false;
+        }
+        offset += sizeof(ListHeader);
+
+        const std::size_t offsets_bytes = (n + 1) * sizeof(std::uint64_t);
+        if (bytes.size() - offset < offsets_bytes ||
+            list_header.entries > (bytes.size() - offset - offsets_bytes) / sizeof(Neighbor)) {
+            return false;
+        }
+
+        const auto* offsets = reinterpret_cast<const std::uint64_t*>(bytes.data() + offset);
+        const auto* entries = reinterpret_cast<const Neighbor*>(bytes.data() + offset + offsets_bytes);
+        offset += offsets_bytes + static_cast<std::size_t>(list_header.entries) * sizeof(Neighbor);
+
+        if (list_header.kind <= static_cast<std::uint32_t>(CandidateKind::Delaunay)) {
+            const ListKey key{static_cast<CandidateKind>(list_header.kind), static_cast<std::size_t>(list_header.k)};
+            mapped_lists_[key] = MappedLists{offsets, entries, list_header.entries, false};
+        }
+    }
+
+    warm_ = true;
+    return true;
+}
+
+bool InstanceCache::find(CandidateKind kind, std::size_t k, NeighborLists& out) const {
+    const ListKey key{kind, k};
+
+    if (const auto built = built_lists_.find(key); built != built_lists_.end()) {
+        out = NeighborLists::view(built->second.offsets.data(), built->second.neighbors.data(), cities_.size());
+        return true;
+    }
+
+    const auto mapped = mapped_lists_.find(key);
+    if (mapped == mapped_lists_.end()) {
+        return false;
+    }
+
+    // Stored lists are checked when first used, so a damaged file costs a rebuild, not a crash.
+    const std::size_t n = cities_.size();
+    const MappedLists& lists = mapped->second;
+    if (!lists.checked) {
+        if (lists.offsets[0] != 0 || lists.offsets[n] != lists.count) {
+            return false;
+        }
+        for (std::size_t city = 0; city < n; ++city) {
+            if (lists.offsets[city] > lists.offsets[city + 1]) {
+                return false;
+            }
+        }
+
+        const auto count = static_cast<std::size_t>(lists.count);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (lists.entries[i].city >= n) {
+                return false;
+            }
+        }
+        lists.checked = true;
+    }
+
+    out = NeighborLists::view(lists.offsets, lists.entries, n);
+    return true;
+}
+
+void InstanceCache::store(CandidateKind kind, std::size_t k, const NeighborLists& lists) {
+    const std::size_t n = cities_.size();
+    BuiltLists& built = built_lists_[{kind, k}];
+
+    built.offsets.resize(n + 1);
+    for (std::size_t city = 0; city <= n; ++city) {
+        built.offsets[city] = city < n ? lists.offset(city) : lists.entries();
+    }
+    built.neighbors.assign(lists.entries() > 0 ? lists[0].begin() : nullptr,
+                           lists.entries() > 0 ? lists[0].begin() + lists.entries() : nullptr);
+    dirty_ = files_enabled_;
+}
+
+void InstanceCache::save() {
+    if (!dirty_) {
+        return;
+    }
+
+    try {
+        write_binary();
+        dirty_ = false;
+    }
+    catch (const std::exception&) {
+        std::error_code ignored;
+        std::filesystem::remove(binary_path_ + ".tmp", ignored);
+    }
+}
+
+void InstanceCache::write_binary() const {
+    const std::size_t n = cities_.size();
+
+    // Lists built in this process win over mapped ones with the same key.
+    std::map<ListKey, NeighborLists> lists;
+    for (const auto& [key, built]: built_lists_) {
+        find(key.first, key.second, lists[key]);
+    }
+    for (const auto& [key, mapped]: mapped_lists_) {
+        NeighborLists view;
+        if (lists.count(key) == 0 && find(key.first, key.second, view)) {
+            lists.emplace(key, std::move(view));
+        }
+    }
+
+    const std::string temporary = binary_path_ + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to create instance cache: " + temporary);
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = INSTANCE_CACHE_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.list_count = static_cast<std::uint32_t>(lists.size());
+    header.source_hash = source_hash_;
+    header.source_size = source_size_;
+    header.cities = n;
+    write_raw(out, &header, 1);
+
+    std::vector<double> coordinates(2 * n);
+    for (const auto& city: cities_) {
+        const auto index = static_cast<std::size_t>(city.id - 1);
+        coordinates[index] = city.point.first;
+        coordinates[n + index] = city.point.second;
+    }
+    write_raw(out, coordinates.data(), coordinates.size());
+
+    std::vector<std::uint64_t> offsets(n + 1);
+    for (const auto& [key, neighbor_lists]: lists) {
+        const ListHeader list_header{static_cast<std::uint32_t>(key.first), 0, key.second, neighbor_lists.entries()};
+        write_raw(out, &list_header, 1);
+
+        for (std::size_t city = 0; city <= n; ++city) {
+            offsets[city] = city < n ? neighbor_lists.offset(city) : neighbor_lists.entries();
+        }
+        write_raw(out, offsets.data(), offsets.size());
+
+        if (neighbor_lists.entries() > 0) {
+            write_raw(out, neighbor_lists[0].begin(), neighbor_lists.entries());
+        }
+    }
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write instance cache: " + temporary);
+    }
+
+    std::filesystem::rename(temporary, binary_path_);
+}
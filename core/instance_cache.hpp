@@ -0,0 +1,85 @@
+#ifndef TSP_CORE_INSTANCE_CACHE
+#define TSP_CORE_INSTANCE_CACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "config.hpp"
+#include "mapped_file.hpp"
+#include "tsp.hpp"
+
+// Bumped whenever the .tspb layout changes; files of other versions are regenerated.
+constexpr std::uint32_t INSTANCE_CACHE_VERSION = 1;
+
+// 64-bit hash of raw bytes, used to tie a .tspb file to the exact .tsp it was built from.
+std::uint64_t content_hash(std::string_view bytes);
+
+// The .tspb file stored next to a .tsp: same path with the extension replaced.
+std::string binary_instance_path(const std::string& filename);
+
+// A TSPLIB instance loaded through its binary cache. The .tspb holds the coordinates, the hash
+// of the source .tsp and any candidate lists built for the instance; it is memory-mapped
+// read-only and used only while that hash still matches, otherwise the .tsp is parsed and the
+// cache rewritten. TSP_INSTANCE_CACHE=off skips the files and always parses.
+//
+// A PreparedInstance built from the cache takes its candidate lists from here and records the
+// ones it builds, so runners share them across runs; save() persists the newly built lists.
+class InstanceCache {
+public:
+    explicit InstanceCache(const std::string& filename);
+
+    InstanceCache(const InstanceCache&) = delete;
+    InstanceCache& operator=(const InstanceCache&) = delete;
+
+    const std::vector<City>& cities() const { return cities_; }
+
+    // True when the cities came from an up-to-date .tspb instead of the parser.
+    bool warm() const { return warm_; }
+
+    // Rewrites the .tspb when lists were built since loading. Failures to write are ignored:
+    // the cache is an optimization and read-only trees must still work.
+    void save();
+
+    // Sets out to a view of the cached lists, valid while this object is alive and the key is
+    // not stored again.
+    bool find(CandidateKind kind, std::size_t k, NeighborLists& out) const;
+    void store(CandidateKind kind, std::size_t k, const NeighborLists& lists);
+
+private:
+    struct MappedLists {
+        const std::uint64_t* offsets;
+        const Neighbor* entries;
+        std::uint64_t count;
+        mutable bool checked;
+    };
+
+    struct BuiltLists {
+        std::vector<std::uint64_t> offsets;
+        std::vector<Neighbor> neighbors;
+    };
+
+    using ListKey = std::pair<CandidateKind, std::size_t>;
+
+    bool load_binary(std::string_view source);
+    void write_binary() const;
+
+    std::string filename_;
+    std::string binary_path_;
+    std::uint64_t source_hash_ = 0;
+    std::uint64_t source_size_ = 0;
+    std::vector<City> cities_;
+    bool files_enabled_ = true;
+    bool warm_ = false;
+    bool dirty_ = false;
+    std::unique_ptr<MappedFile> binary_;
+    std::map<ListKey, MappedLists> mapped_lists_;
+    std::map<ListKey, BuiltLists> built_lists_;
+};
+
+#endif
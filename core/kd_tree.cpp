@@ -0,0 +1,174 @@
+#include "kd_tree.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+bool closer(const Neighbor& lhs, const Neighbor& rhs) {
+    return lhs.distance != rhs.distance ? lhs.distance < rhs.distance : lhs.city < rhs.city;
+}
+
+}
+
+KdTree::KdTree(const CoordinateDistance& coordinates) : coordinates_(coordinates), order_(coordinates.size()) {
+    double scale = 0.0;
+
+    for (std::size_t i = 0; i < order_.size(); ++i) {
+        order_[i] = static_cast<std::uint32_t>(i);
+        scale = std::max({scale, std::fabs(coordinates_.x()[i]), std::fabs(coordinates_.y()[i])});
+    }
+
+    // Box bounds and tour distances round differently; the margin keeps pruning conservative.
+    margin_ = 1e-9 * (1.0 + scale);
+
+    if (!order_.empty()) {
+        nodes_.reserve(2 * (order_.size() / LEAF_SIZE + 1));
+        build(0, static_cast<std::uint32_t>(order_.size()));
+    }
+}
+
+std::uint32_t KdTree::build(std::uint32_t begin, std::uint32_t end) {
+    const auto& x = coordinates_.x();
+    const auto& y = coordinates_.y();
+
+    Node node{x[order_[begin]], y[order_[begin]], x[order_[begin]], y[order_[begin]], begin, end, LEAF, LEAF};
+    for (std::uint32_t i = begin; i < end; ++i) {
+        node.min_x = std::min(node.min_x, x[order_[i]]);
+        node.min_y = std::min(node.min_y, y[order_[i]]);
+        node.max_x = std::max(node.max_x, x[order_[i]]);
+        node.max_y = std::max(node.max_y, y[order_[i]]);
+    }
+
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(node);
+
+    if (end - begin <= LEAF_SIZE) {
+        return index;
+    }
+
+    const auto& axis = node.max_x - node.min_x >= node.max_y - node.min_y ? x : y;
+    const std::uint32_t middle = begin + (end - begin) / 2;
+
+    std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                     [&](std::uint32_t lhs, std::uint32_t rhs) { return axis[lhs] < axis[rhs]; });
+
+    const std::uint32_t left = build(begin, middle);
+    const std::uint32_t right = build(middle, end);
+    nodes_[index].left = left;
+    nodes_[index].right = right;
+
+    return index;
+}
+
+template <typename Accept, typename Reachable>
+void KdTree::search(std::size_t city, std::size_t limit, std::vector<Neighbor>& out, Accept accept,
+                    Reachable reachable) const {
+    out.clear();
+
+    if (limit == 0 || order_.empty()) {
+        return;
+    }
+
+    const double px = coordinates_.x()[city];
+    const double py = coordinates_.y()[city];
+
+    auto lower_bound = [&](const Node& node) {
+        const double dx = std::max({node.min_x - px, px - node.max_x, 0.0});
+        const double dy = std::max({node.min_y - py, py - node.max_y, 0.0});
+
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    // A subtree can be skipped once even its closest point rounds above the current k-th distance.
+    auto pruned = [&](double bound) {
+        return out.size() == limit && bound - margin_ >= static_cast<double>(out.front().distance) + 0.5;
+    };
+
+    std::uint32_t stack[128];
+    std::size_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+
+        if (!reachable(node) || pruned(lower_bound(node))) {
+            continue;
+        }
+
+        if (node.left == LEAF) {
+            for (std::uint32_t i = node.begin; i < node.end; ++i) {
+                const std::uint32_t other = order_[i];
+                if (other == city || !accept(other)) {
+                    continue;
+                }
+
+                const Neighbor candidate{other, coordinates_(city, other)};
+                if (out.size() < limit) {
+                    out.push_back(candidate);
+                    std::push_heap(out.begin(), out.end(), closer);
+                }
+                else if (closer(candidate, out.front())) {
+                    std::pop_heap(out.begin(), out.end(), closer);
+                    out.back() = candidate;
+                    std::push_heap(out.begin(), out.end(), closer);
+                }
+            }
+            continue;
+        }
+
+        const bool left_first = lower_bound(nodes_[node.left]) <= lower_bound(nodes_[node.right]);
+        stack[top++] = left_first ? node.right : node.left;
+        stack[top++] = left_first ? node.left : node.right;
+    }
+
+    std::sort_heap(out.begin(), out.end(), closer);
+}
+
+int KdTree::quadrant_of(double dx, double dy) {
+    if (dx > 0.0 && dy >= 0.0) {
+        return 0;
+    }
+    if (dx <= 0.0 && dy > 0.0) {
+        return 1;
+    }
+    if (dx < 0.0 && dy <= 0.0) {
+        return 2;
+    }
+    if (dx >= 0.0 && dy < 0.0) {
+        return 3;
+    }
+
+    return 0;
+}
+
+void KdTree::nearest(std::size_t city, std::size_t k, std::vector<Neighbor>& out) const {
+    const std::size_t limit = order_.empty() ? 0 : std::min(k, order_.size() - 1);
+
+    search(city, limit, out, [](std::uint32_t) { return true; }, [](const Node&) { return true; });
+}
+
+void KdTree::nearest_in_quadrant(std::size_t city, int quadrant, std::size_t k, std::vector<Neighbor>& out) const {
+    const double px = coordinates_.x()[city];
+    const double py = coordinates_.y()[city];
+
+    auto accept = [&](std::uint32_t other) {
+        return quadrant_of(coordinates_.x()[other] - px, coordinates_.y()[other] - py) == quadrant;
+    };
+    // Conservative box test: the box reaches the closed quadrant around the city.
+    auto reachable = [&](const Node& node) {
+        const bool right = node.max_x >= px;
+        const bool left = node.min_x <= px;
+        const bool above = node.max_y >= py;
+        const bool below = node.min_y <= py;
+
+        switch (quadrant) {
+            case 0: return right && above;
+            case 1: return left && above;
+            case 2: return left && below;
+            default: return right && below;
+        }
+    };
+
+    search(city, k, out, accept, reachable);
+}
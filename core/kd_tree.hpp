@@ -0,0 +1,57 @@
+#ifndef TSP_CORE_KD_TREE
+#define TSP_CORE_KD_TREE
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "coordinate_distance.hpp"
+#include "neighbor_lists.hpp"
+
+// 2-d tree over city coordinates for exact k-nearest-neighbor queries under rounded EUC_2D
+// distances. Results are ordered by (distance, city index), matching a full scan.
+class KdTree {
+public:
+    explicit KdTree(const CoordinateDistance& coordinates);
+
+    // Cities in leaf order; queries issued in this order touch nearby tree nodes consecutively.
+    const std::vector<std::uint32_t>& order() const { return order_; }
+
+    // Writes the k nearest cities to `city` (excluding itself) into out, sorted.
+    void nearest(std::size_t city, std::size_t k, std::vector<Neighbor>& out) const;
+
+    // Same, restricted to one quadrant around `city` (see quadrant_of).
+    void nearest_in_quadrant(std::size_t city, int quadrant, std::size_t k, std::vector<Neighbor>& out) const;
+
+    // Quadrant 0..3 of offset (dx, dy), counter-clockwise from +x; half-axes are split so each
+    // offset has exactly one quadrant, and a coincident city belongs to quadrant 0.
+    static int quadrant_of(double dx, double dy);
+
+private:
+    struct Node {
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t left;
+        std::uint32_t right;
+    };
+
+    static constexpr std::uint32_t LEAF = 0;
+    static constexpr std::size_t LEAF_SIZE = 8;
+
+    std::uint32_t build(std::uint32_t begin, std::uint32_t end);
+
+    template <typename Accept, typename Reachable>
+    void search(std::size_t city, std::size_t limit, std::vector<Neighbor>& out, Accept accept,
+                Reachable reachable) const;
+
+    CoordinateDistance coordinates_;
+    std::vector<std::uint32_t> order_;
+    std::vector<Node> nodes_;
+    double margin_ = 0.0;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef TSP_CORE_LOCAL_SEARCH
+#define TSP_CORE_LOCAL_SEARCH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "config.hpp"
+#include "tsp.hpp"
+#include "two_level_tour.hpp"
+
+// Scratch state of the neighbor-list local searches. A solver keeps one per run and passes it to
+// every call, so polishing allocates nothing once the buffers have grown to the instance size.
+// Seeding restricts the next search to the cities an operator changed: it starts with only those
+// active, and only the queue entries it touched are cleared afterwards. Every search clears the
+// seeds. Searches on a Tour still index it (and regroup it for the two-level store) on each call;
+// array_local_search_unchecked on a tour whose positions the caller keeps does neither, so a
+// seeded search there costs what its moves cost rather than O(n).
+struct LocalSearchWorkspace {
+    // Adds city to the next search's starting active set.
+    void seed(std::size_t city) { seeds.push_back(static_cast<std::uint32_t>(city)); }
+
+    // The next search's starting active set; empty starts from every city.
+    std::vector<std::uint32_t> seeds;
+
+    // How much shorter the last search made the tour: the sum of its applied moves' gains.
+    std::int64_t gain = 0;
+
+    // Buffers for the searches themselves.
+    std::vector<std::uint32_t> positions;
+    std::vector<char> queued;
+    std::vector<std::uint32_t> active;
+    TwoLevelTour two_level;
+};
+
+// Runs the neighbor-list local search a solver's local_search setting selects.
+template <typename Distance>
+std::size_t local_search_unchecked(Tour& tour, const Distance& distances, const NeighborLists& neighbors,
+                                   LocalSearch kind, std::size_t max_moves,
+                                   const RunController* controller = nullptr,
+                                   LocalSearchWorkspace* workspace = nullptr) {
+    switch (kind) {
+        case LocalSearch::OrOpt:
+            return two_opt_or_opt_neighbors_unchecked(tour, distances, neighbors, max_moves, controller, workspace);
+        case LocalSearch::LinKernighan:
+            return lin_kernighan_neighbors_unchecked(tour, distances, neighbors, max_moves, controller, workspace);
+        case LocalSearch::TwoOpt:
+            break;
+    }
+
+    return two_opt_neighbors_unchecked(tour, distances, neighbors, max_moves, controller, workspace);
+}
+
+// local_search_unchecked on an n-city tour stored at tour, with positions[city] the city's index
+// in it; both are updated in place. Always uses the array store, whatever n.
+template <typename Distance>
+std::size_t array_local_search_unchecked(std::uint32_t* tour, std::uint32_t* positions, std::size_t n,
+                                         const Distance& distances, const NeighborLists& neighbors, LocalSearch kind,
+                                         std::size_t max_moves, const RunController* controller,
+                                         LocalSearchWorkspace& workspace);
+
+#endif
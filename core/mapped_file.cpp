@@ -0,0 +1,63 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TSP_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef TSP_HAS_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open TSPLIB file: " + filename);
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat TSPLIB file: " + filename);
+    }
+
+    // mmap rejects zero-length mappings; an empty file is simply an empty view.
+    if (info.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map TSPLIB file: " + filename);
+        }
+        ::madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+
+        data_ = static_cast<const char*>(data);
+        size_ = static_cast<std::size_t>(info.st_size);
+        mapped_ = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open TSPLIB file: " + filename);
+    }
+
+    fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef TSP_HAS_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
@@ -0,0 +1,28 @@
+#ifndef TSP_CORE_MAPPED_FILE
+#define TSP_CORE_MAPPED_FILE
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. The file is memory-mapped where the platform allows it, so
+// parsers can scan multi-megabyte inputs without copying them into std::string buffers first.
+class MappedFile {
+public:
+    // Throws std::runtime_error when the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view text() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string fallback_;
+};
+
+#endif
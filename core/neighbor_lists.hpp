@@ -0,0 +1,157 @@
+#ifndef TSP_CORE_NEIGHBOR_LISTS
+#define TSP_CORE_NEIGHBOR_LISTS
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct Neighbor {
+    std::uint32_t city;
+    std::int32_t distance;
+};
+
+class NeighborRange {
+public:
+    NeighborRange(const Neighbor* first, const Neighbor* last) : first_(first), last_(last) {}
+
+    const Neighbor* begin() const { return first_; }
+    const Neighbor* end() const { return last_; }
+    std::size_t size() const { return static_cast<std::size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+    const Neighbor& operator[](std::size_t i) const { return first_[i]; }
+
+private:
+    const Neighbor* first_;
+    const Neighbor* last_;
+};
+
+// Candidate neighbors of every city stored back to back, each list sorted by ascending distance.
+// Distances are cached next to the city index so local search never recomputes them. The CSR
+// arrays are either owned or viewed in place, e.g. in a mapped .tspb file.
+class NeighborLists {
+public:
+    NeighborLists() = default;
+
+    // Takes ownership of lists that all hold exactly per_city entries, concatenated in city order.
+    NeighborLists(std::vector<Neighbor> entries, std::size_t per_city) : entries_(std::move(entries)) {
+        const std::size_t cities = per_city == 0 ? 0 : entries_.size() / per_city;
+
+        offsets_.resize(cities + 1);
+        for (std::size_t city = 0; city <= cities; ++city) {
+            offsets_[city] = city * per_city;
+        }
+        attach();
+    }
+
+    // Takes ownership of CSR storage: city i owns entries [offsets[i], offsets[i + 1]).
+    NeighborLists(std::vector<std::uint64_t> offsets, std::vector<Neighbor> entries)
+        : offsets_(std::move(offsets)), entries_(std::move(entries)) {
+        attach();
+    }
+
+    // Views CSR storage of the given number of cities owned elsewhere, without copying it. The
+    // storage must outlive these lists and every copy of them; append and reserve copy it first.
+    static NeighborLists view(const std::uint64_t* offsets, const Neighbor* entries, std::size_t cities) {
+        NeighborLists lists;
+        lists.offset_data_ = offsets;
+        lists.entry_data_ = entries;
+        lists.cities_ = cities;
+        lists.entry_count_ = static_cast<std::size_t>(offsets[cities]);
+        return lists;
+    }
+
+    NeighborLists(const NeighborLists& other) { *this = other; }
+    NeighborLists(NeighborLists&& other) noexcept { *this = std::move(other); }
+
+    NeighborLists& operator=(const NeighborLists& other) {
+        if (this != &other) {
+            offsets_ = other.offsets_;
+            entries_ = other.entries_;
+            take_storage(other, other.viewed());
+        }
+        return *this;
+    }
+
+    NeighborLists& operator=(NeighborLists&& other) noexcept {
+        if (this != &other) {
+            const bool viewed = other.viewed();
+            offsets_ = std::move(other.offsets_);
+            entries_ = std::move(other.entries_);
+            take_storage(other, viewed);
+            other.offsets_.clear();
+            other.entries_.clear();
+            other.attach();
+        }
+        return *this;
+    }
+
+    std::size_t size() const { return cities_; }
+    std::size_t entries() const { return entry_count_; }
+
+    NeighborRange operator[](std::size_t city) const {
+        return {entry_data_ + offset_data_[city], entry_data_ + offset_data_[city + 1]};
+    }
+
+    // Lists must be appended in city order; an empty append still closes that city's list.
+    void append(const Neighbor* first, const Neighbor* last) {
+        own();
+        if (offsets_.empty()) {
+            offsets_.push_back(0);
+        }
+        entries_.insert(entries_.end(), first, last);
+        offsets_.push_back(entries_.size());
+        attach();
+    }
+
+    void reserve(std::size_t cities, std::size_t entries) {
+        own();
+        offsets_.reserve(cities + 1);
+        entries_.reserve(entries);
+        attach();
+    }
+
+    // Index of the first entry of city's list, for storage kept parallel to the entries.
+    std::size_t offset(std::size_t city) const { return static_cast<std::size_t>(offset_data_[city]); }
+
+    // True when the lists view storage they do not own.
+    bool viewed() const { return offset_data_ != nullptr && offset_data_ != offsets_.data(); }
+
+private:
+    void attach() {
+        offset_data_ = offsets_.data();
+        entry_data_ = entries_.data();
+        cities_ = offsets_.empty() ? 0 : offsets_.size() - 1;
+        entry_count_ = entries_.size();
+    }
+
+    // Copies viewed storage into owned vectors.
+    void own() {
+        if (viewed()) {
+            offsets_.assign(offset_data_, offset_data_ + cities_ + 1);
+            entries_.assign(entry_data_, entry_data_ + entry_count_);
+        }
+    }
+
+    // Points at other's storage: the vectors just copied or moved from it if it owned its
+    // arrays, otherwise the same viewed arrays.
+    void take_storage(const NeighborLists& other, bool viewed) {
+        if (viewed) {
+            offset_data_ = other.offset_data_;
+            entry_data_ = other.entry_data_;
+            cities_ = other.cities_;
+            entry_count_ = other.entry_count_;
+        } else {
+            attach();
+        }
+    }
+
+    std::vector<std::uint64_t> offsets_;
+    std::vector<Neighbor> entries_;
+    const std::uint64_t* offset_data_ = nullptr;
+    const Neighbor* entry_data_ = nullptr;
+    std::size_t cities_ = 0;
+    std::size_t entry_count_ = 0;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "prepared_instance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "candidates.hpp"
+#include "instance_cache.hpp"
+
+void InstanceRequirements::merge(const InstanceRequirements& other) {
+    pair_bytes = std::max(pair_bytes, other.pair_bytes);
+
+    for (const auto& request: other.candidates) {
+        if (std::find(candidates.begin(), candidates.end(), request) == candidates.end()) {
+            candidates.push_back(request);
+        }
+    }
+}
+
+PreparedInstance::PreparedInstance(std::vector<City> cities, const InstanceRequirements& requirements)
+    : PreparedInstance(std::move(cities), requirements, nullptr) {}
+
+PreparedInstance::PreparedInstance(InstanceCache& cache, const InstanceRequirements& requirements)
+    : PreparedInstance(cache.cities(), requirements, &cache) {}
+
+PreparedInstance::PreparedInstance(std::vector<City> cities, const InstanceRequirements& requirements,
+                                   InstanceCache* cache) {
+    const auto start = std::chrono::steady_clock::now();
+
+    validate_tour_input(cities, "Instance preparation");
+    std::sort(cities.begin(), cities.end());
+    cities_ = std::move(cities);
+
+    distances_ = visit_distances(cities_, [](auto&& distances) {
+        return Distances(std::forward<decltype(distances)>(distances));
+    }, requirements.pair_bytes);
+
+    for (const auto& request: requirements.candidates) {
+        if (std::any_of(candidates_.begin(), candidates_.end(),
+                        [&](const auto& entry) { return entry.first == request; })) {
+            continue;
+        }
+
+        NeighborLists lists;
+        if (cache == nullptr || !cache->find(request.kind, request.k, lists)) {
+            lists = build_candidate_lists(cities_, request.kind, request.k);
+            if (cache != nullptr) {
+                cache->store(request.kind, request.k, lists);
+                cache->find(request.kind, request.k, lists);
+            }
+        }
+        candidates_.emplace_back(request, std::move(lists));
+    }
+
+    seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const NeighborLists& PreparedInstance::candidates(CandidateKind kind, std::size_t k) const {
+    for (const auto& [request, lists]: candidates_) {
+        if (request.kind == kind && request.k == k) {
+            return lists;
+        }
+    }
+
+    throw std::invalid_argument("Prepared instance has no " + candidate_kind_text(kind) + " candidate lists of size " +
+                                std::to_string(k) + ".");
+}
+
+void PreparedInstance::validate_tour(const std::vector<City>& tour, const std::string& algorithm_name) const {
+    validate_tour_input(tour, algorithm_name);
+
+    if (tour.size() != cities_.size()) {
+        throw std::invalid_argument(algorithm_name + " tour does not match the prepared instance.");
+    }
+    for (const auto& city: tour) {
+        if (!(cities_[static_cast<std::size_t>(city.id - 1)] == city)) {
+            throw std::invalid_argument(algorithm_name + " tour does not match the prepared instance.");
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef TSP_CORE_PREPARED_INSTANCE
+#define TSP_CORE_PREPARED_INSTANCE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "config.hpp"
+#include "tsp.hpp"
+
+class InstanceCache;
+
+struct CandidateRequest {
+    CandidateKind kind;
+    std::size_t k;
+
+    bool operator==(const CandidateRequest& other) const { return kind == other.kind && k == other.k; }
+};
+
+// What a solver needs prepared: candidate lists, and per-pair state it allocates itself (which
+// counts against the distance budget when the storage is chosen).
+struct InstanceRequirements {
+    std::size_t pair_bytes = 0;
+    std::vector<CandidateRequest> candidates;
+
+    // Union of both, so one instance can serve several solvers.
+    void merge(const InstanceRequirements& other);
+};
+
+// Everything solvers derive from an instance before they search: the cities in id order, the
+// distance storage visit_distances would choose, and candidate lists. Built once, then shared
+// read-only by every runner, repeat and --jobs worker on the instance.
+class PreparedInstance {
+public:
+    using Distances = std::variant<DistanceMatrix<std::uint16_t>, DistanceMatrix<std::int32_t>,
+                                   PackedDistanceMatrix<std::uint16_t>, PackedDistanceMatrix<std::int32_t>,
+                                   CoordinateDistance>;
+
+    // Validates the cities (any order) and builds what requirements ask for.
+    PreparedInstance(std::vector<City> cities, const InstanceRequirements& requirements);
+
+    // Prepares the cache's instance, viewing the candidate lists it holds and recording the
+    // ones built here. The lists stay views into the cache, so it must outlive this object.
+    PreparedInstance(InstanceCache& cache, const InstanceRequirements& requirements);
+
+    const std::vector<City>& cities() const { return cities_; }
+    std::size_t size() const { return cities_.size(); }
+
+    // Calls fn with the concrete distance provider, like visit_distances.
+    template <typename Fn>
+    decltype(auto) visit(Fn&& fn) const {
+        return std::visit(std::forward<Fn>(fn), distances_);
+    }
+
+    // Throws std::invalid_argument when the lists were not requested at preparation.
+    const NeighborLists& candidates(CandidateKind kind, std::size_t k) const;
+
+    // Throws std::invalid_argument unless tour visits exactly this instance's cities.
+    void validate_tour(const std::vector<City>& tour, const std::string& algorithm_name) const;
+
+    // Wall-clock seconds spent preparing.
+    double seconds() const { return seconds_; }
+
+private:
+    PreparedInstance(std::vector<City> cities, const InstanceRequirements& requirements, InstanceCache* cache);
+
+    std::vector<City> cities_;
+    Distances distances_;
+    std::vector<std::pair<CandidateRequest, NeighborLists>> candidates_;
+    double seconds_ = 0.0;
+};
+
+#endif
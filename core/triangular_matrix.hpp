@@ -0,0 +1,45 @@
+#ifndef TSP_CORE_TRIANGULAR_MATRIX
+#define TSP_CORE_TRIANGULAR_MATRIX
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Symmetric n x n matrix stored as its packed upper triangle (diagonal included), column by
+// column: n (n + 1) / 2 entries, so (i, j) and (j, i) share one slot.
+template <typename T>
+class TriangularMatrix {
+public:
+    using value_type = T;
+
+    TriangularMatrix() = default;
+    explicit TriangularMatrix(std::size_t n, T fill = T{0}) : n_(n), data_(n * (n + 1) / 2, fill) {}
+
+    // Branch-free: min/max compile to conditional moves and the column start is a triangular number.
+    static std::size_t index(std::size_t i, std::size_t j) {
+        const std::size_t low = std::min(i, j);
+        const std::size_t high = i ^ j ^ low;
+
+        return high * (high + 1) / 2 + low;
+    }
+
+    std::size_t size() const { return n_; }
+    std::size_t bytes() const { return data_.size() * sizeof(T); }
+
+    T operator()(std::size_t i, std::size_t j) const { return data_[index(i, j)]; }
+    T& at(std::size_t i, std::size_t j) { return data_[index(i, j)]; }
+    void set(std::size_t i, std::size_t j, T value) { data_[index(i, j)] = value; }
+
+    // Column j holds (0, j) .. (j, j) contiguously.
+    const T* column(std::size_t j) const { return data_.data() + j * (j + 1) / 2; }
+    T* column(std::size_t j) { return data_.data() + j * (j + 1) / 2; }
+
+    typename std::vector<T>::iterator begin() { return data_.begin(); }
+    typename std::vector<T>::iterator end() { return data_.end(); }
+
+private:
+    std::size_t n_ = 0;
+    std::vector<T> data_;
+};
+
+#endif
@@ -1,18 +1,23 @@
 #include "tsp.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cmath>
-#include <fstream>
-#include <queue>
+#include <cstdlib>
 #include <sstream>
 #include <stdexcept>
-#include <unordered_set>
+#include <thread>
+#include <string_view>
+#include <type_traits>
 
-namespace {
+#include "array_tour.hpp"
+#include "distance_kernels.hpp"
+#include "local_search.hpp"
+#include "mapped_file.hpp"
+#include "two_level_tour.hpp"
 
-std::size_t matrix_index(std::size_t i, std::size_t j, std::size_t n) {
-    return i * n + j;
-}
+namespace {
 
 std::string trim_line(const std::string& text) {
     const auto first = text.find_first_not_of(" \t\r\n");
@@ -50,12 +55,496 @@ bool parse_tsplib_field(const std::string& line, const std::string& key, std::st
     return true;
 }
 
+constexpr std::string_view BLANKS = " \t\r\n\v\f";
+
+std::string_view trim_view(std::string_view text) {
+    const auto first = text.find_first_not_of(BLANKS);
+
+    if (first == std::string_view::npos) {
+        return {};
+    }
+
+    return text.substr(first, text.find_last_not_of(BLANKS) - first + 1);
+}
+
+// Splits the next line (without its newline) off the front of rest; false once rest is exhausted.
+bool next_line(std::string_view& rest, std::string_view& line) {
+    if (rest.empty()) {
+        return false;
+    }
+
+    const auto newline = rest.find('\n');
+    line = rest.substr(0, newline);
+    rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+
+    return true;
+}
+
+// Parses the next whitespace-separated token of fields as a whole number, consuming it.
+// Accepts what the old stream extraction accepted for well-formed TSPLIB data, including a leading '+'.
+template <typename T>
+bool parse_field(std::string_view& fields, T& value) {
+    const auto first = fields.find_first_not_of(BLANKS);
+    if (first == std::string_view::npos) {
+        return false;
+    }
+    fields.remove_prefix(first);
+
+    const std::string_view token = fields.substr(0, fields.find_first_of(BLANKS));
+    fields.remove_prefix(token.size());
+
+    const char* begin = token.data();
+    const char* end = begin + token.size();
+    if (token.size() > 1 && *begin == '+' && begin[1] != '-') {
+        ++begin;
+    }
+
+    const auto [ptr, error] = std::from_chars(begin, end, value);
+    return error == std::errc{} && ptr == end;
+}
+
+template <typename T>
+CoordinateDistance coordinates_for_matrix(const std::vector<City>& cities, const std::string& name) {
+    validate_tour_input(cities, name);
+
+    if (max_distance_bound(cities) > static_cast<std::int64_t>(std::numeric_limits<T>::max())) {
+        throw std::invalid_argument(name + " element type is too narrow for the city coordinates.");
+    }
+
+    std::vector<double> x(cities.size());
+    std::vector<double> y(cities.size());
+    for (const auto& city: cities) {
+        x[static_cast<std::size_t>(city.id - 1)] = city.point.first;
+        y[static_cast<std::size_t>(city.id - 1)] = city.point.second;
+    }
+
+    return {std::move(x), std::move(y)};
+}
+
+// Rows (dense) or columns (packed) handed to a thread at a time.
+constexpr std::size_t DENSE_ROW_CHUNK = 64;
+constexpr std::size_t PACKED_COLUMN_CHUNK = 64;
+
+// Runs task(0) .. task(count - 1) on every hardware thread, handing out indices in increasing
+// order so the largest tasks should come first.
+template <typename Task>
+void parallel_tasks(std::size_t count, Task task) {
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t index = next++; index < count; index = next++) {
+            task(index);
+        }
+    };
+
+    const std::size_t threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::thread> helpers;
+    helpers.reserve(threads > 0 ? threads - 1 : 0);
+    for (std::size_t t = 1; t < threads; ++t) {
+        helpers.emplace_back(worker);
+    }
+
+    worker();
+    for (auto& helper: helpers) {
+        helper.join();
+    }
+}
+
+// Move types a NeighborSearch tries on each active city, in this order.
+enum SearchMoves : unsigned {
+    MOVE_LIN_KERNIGHAN = 1,
+    MOVE_TWO_OPT = 2,
+    MOVE_OR_OPT = 4
+};
+
+// Local search driven by neighbor lists over an ArrayTour or a TwoLevelTour. The workspace's
+// seeds, or every city in tour order (order holds n cities) when there are none, start in a FIFO
+// of active cities; a city whose moves all fail drops out (its don't-look bit is set) and comes
+// back only when an applied move changes one of its tour edges. The FIFO lives in the workspace,
+// as a ring of n slots: a city is queued at most once. Queued flags are zero between searches, and
+// a search unqueues whatever it leaves in the FIFO, so a seeded search never touches all n.
+template <typename Distance, typename TourStore>
+class NeighborSearch {
+public:
+    NeighborSearch(TourStore& tour, const std::uint32_t* order, const Distance& distances,
+                   const NeighborLists& neighbors, const RunController* controller, LocalSearchWorkspace& workspace)
+        : tour_(tour), distances_(distances), neighbors_(neighbors), controller_(controller), n_(tour.size()),
+          queued_(workspace.queued), active_(workspace.active) {
+        if (queued_.size() != n_) {
+            queued_.assign(n_, 0);
+        }
+        active_.resize(n_);
+        if (workspace.seeds.empty()) {
+            for (std::size_t i = 0; i < n_; ++i) {
+                activate(order[i]);
+            }
+        }
+        for (const std::uint32_t city: workspace.seeds) {
+            activate(city);
+        }
+    }
+
+    ~NeighborSearch() {
+        for (; active_count_ > 0; --active_count_) {
+            queued_[active_[active_head_]] = 0;
+            active_head_ = (active_head_ + 1) % n_;
+        }
+    }
+
+    NeighborSearch(const NeighborSearch&) = delete;
+    NeighborSearch& operator=(const NeighborSearch&) = delete;
+
+    // How much shorter the applied moves made the tour.
+    std::int64_t gain() const { return gain_; }
+
+    std::size_t run(unsigned moves_to_try, std::size_t max_moves) {
+        std::size_t moves = 0;
+
+        while (active_count_ > 0 && moves < max_moves && !expired()) {
+            const std::size_t c1 = active_[active_head_];
+            active_head_ = (active_head_ + 1) % n_;
+            --active_count_;
+            queued_[c1] = 0;
+
+            if (((moves_to_try & MOVE_LIN_KERNIGHAN) && try_lin_kernighan(c1)) ||
+                ((moves_to_try & MOVE_TWO_OPT) && try_two_opt(c1)) || ((moves_to_try & MOVE_OR_OPT) && try_or_opt(c1))) {
+                ++moves;
+            }
+        }
+
+        return moves;
+    }
+
+private:
+    static constexpr std::size_t MAX_SEGMENT = ArrayTour::MAX_SEGMENT;
+    static constexpr std::size_t LK_DEPTH = 5;
+    // Alternatives tried for the first two added edges; deeper steps only follow the best one.
+    static constexpr std::size_t LK_BREADTH[LK_DEPTH] = {5, 3, 1, 1, 1};
+
+    struct Flip {
+        std::size_t t1;
+        std::size_t t2;
+        std::size_t t3;
+        std::size_t t4;
+    };
+
+    bool expired() const { return controller_ && controller_->time_expired(); }
+
+    std::int64_t dist(std::size_t a, std::size_t b) const { return distances_(a, b); }
+
+    void activate(std::size_t city) {
+        if (!queued_[city]) {
+            queued_[city] = 1;
+            active_[(active_head_ + active_count_) % n_] = static_cast<std::uint32_t>(city);
+            ++active_count_;
+        }
+    }
+
+    // 2-opt move on a tour reading a b ... d c in either direction: reversing b..d turns edges
+    // (a, b) and (d, c) into (a, d) and (b, c). flip(a, d, b) undoes it.
+    void flip(std::size_t a, std::size_t b, std::size_t d) {
+        if (tour_.next(a) == b) {
+            tour_.reverse(b, d);
+        } else {
+            tour_.reverse(d, b);
+        }
+    }
+
+    void undo_flips(std::size_t keep) {
+        while (flip_count_ > keep) {
+            const Flip& last = flips_[--flip_count_];
+            flip(last.t1, last.t4, last.t2);
+        }
+    }
+
+    bool try_two_opt(std::size_t c1) {
+        for (int dir = 0; dir < 2 && !expired(); ++dir) {
+            const std::size_t c2 = (dir == 0) ? tour_.next(c1) : tour_.prev(c1);
+            const std::int64_t d_c1c2 = dist(c1, c2);
+
+            for (const Neighbor& candidate: neighbors_[c1]) {
+                if (expired()) {
+                    break;
+                }
+
+                const std::size_t c3 = candidate.city;
+                const std::int64_t d_c1c3 = candidate.distance;
+                if (d_c1c3 >= d_c1c2) {
+                    break;
+                }
+
+                const std::size_t c4 = (dir == 0) ? tour_.next(c3) : tour_.prev(c3);
+
+                if (c4 == c1) {
+                    continue;
+                }
+
+                const std::int64_t gain = d_c1c2 + dist(c3, c4) - d_c1c3 - dist(c2, c4);
+
+                if (gain > 0) {
+                    if (dir == 0) {
+                        tour_.reverse(c2, c3);
+                    } else {
+                        tour_.reverse(c3, c2);
+                    }
+                    gain_ += gain;
+                    for (const std::size_t c: {c1, c2, c3, c4}) {
+                        activate(c);
+                    }
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Lin-Kernighan step: t1 is fixed, (t1, t2) is the edge removed last and gain what the open
+    // path saves so far. Adds (t2, t3) and removes (t3, t4), applied at once as a flip that closes
+    // the tour with (t4, t1), then goes one level deeper from t4. Returns the gain of the best
+    // closed tour found below, whose flips stay applied, or 0 with the tour restored.
+    std::int64_t lin_kernighan_step(std::size_t depth, std::size_t t1, std::size_t t2, std::int64_t gain) {
+        struct Choice {
+            std::size_t t3;
+            std::size_t t4;
+            std::int64_t score;
+        };
+
+        Choice choices[LK_BREADTH[0]];
+        std::size_t count = 0;
+        const std::size_t breadth = LK_BREADTH[depth];
+        const bool forward = tour_.next(t1) == t2;
+
+        for (const Neighbor& candidate: neighbors_[t2]) {
+            if (gain - candidate.distance <= 0) {
+                break;
+            }
+
+            const std::size_t t3 = candidate.city;
+            const std::size_t t4 = forward ? tour_.prev(t3) : tour_.next(t3);
+            if (t3 == t1 || t4 == t2) {
+                continue;
+            }
+
+            // Keep the best alternatives by what the next open path would save.
+            const Choice choice{t3, t4, dist(t3, t4) - candidate.distance};
+            std::size_t slot = std::min(count, breadth);
+            while (slot > 0 && choices[slot - 1].score < choice.score) {
+                if (slot < breadth) {
+                    choices[slot] = choices[slot - 1];
+                }
+                --slot;
+            }
+            if (slot < breadth) {
+                choices[slot] = choice;
+                count = std::min(count + 1, breadth);
+            }
+        }
+
+        for (std::size_t i = 0; i < count && !expired(); ++i) {
+            const auto [t3, t4, score] = choices[i];
+            const std::int64_t open_gain = gain + score;
+            const std::int64_t closed_gain = open_gain - dist(t4, t1);
+
+            flip(t1, t2, t4);
+            flips_[flip_count_++] = {t1, t2, t3, t4};
+            const std::size_t applied = flip_count_;
+
+            const std::int64_t deeper = depth + 1 < LK_DEPTH ? lin_kernighan_step(depth + 1, t1, t4, open_gain) : 0;
+            if (deeper > 0 && deeper >= closed_gain) {
+                return deeper;
+            }
+            undo_flips(applied);
+            if (closed_gain > 0) {
+                return closed_gain;
+            }
+            undo_flips(applied - 1);
+        }
+
+        return 0;
+    }
+
+    // Variable-depth move of up to LK_DEPTH sequential flips (a 5-opt move at most) starting with
+    // either tour edge of c1; its first level is exactly the 2-opt neighborhood.
+    bool try_lin_kernighan(std::size_t c1) {
+        for (int dir = 0; dir < 2 && !expired(); ++dir) {
+            const std::size_t c2 = (dir == 0) ? tour_.next(c1) : tour_.prev(c1);
+
+            const std::int64_t gain = lin_kernighan_step(0, c1, c2, dist(c1, c2));
+            if (gain > 0) {
+                gain_ += gain;
+                for (std::size_t i = 0; i < flip_count_; ++i) {
+                    for (const std::size_t c: {flips_[i].t1, flips_[i].t2, flips_[i].t3, flips_[i].t4}) {
+                        activate(c);
+                    }
+                }
+                flip_count_ = 0;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Or-opt: moves a segment of 1 to 3 cities that starts or ends at c1 between two adjacent cities
+    // near one of its ends, in either orientation. As in 2-opt, a candidate is tried only while the
+    // new edge to it is shorter than what removing the segment saves.
+    bool try_or_opt(std::size_t c1) {
+        for (std::size_t len = 1; len <= MAX_SEGMENT && len + 3 <= n_; ++len) {
+            for (int dir = 0; dir < (len == 1 ? 1 : 2); ++dir) {
+                std::size_t segment[MAX_SEGMENT];
+                segment[dir == 0 ? 0 : len - 1] = c1;
+                for (std::size_t i = 1; i < len; ++i) {
+                    if (dir == 0) {
+                        segment[i] = tour_.next(segment[i - 1]);
+                    } else {
+                        segment[len - 1 - i] = tour_.prev(segment[len - i]);
+                    }
+                }
+
+                const std::size_t first = segment[0];
+                const std::size_t last = segment[len - 1];
+                const std::size_t prev = tour_.prev(first);
+                const std::size_t next = tour_.next(last);
+                const std::int64_t removed = dist(prev, first) + dist(last, next) - dist(prev, next);
+
+                if (removed <= 0) {
+                    continue;
+                }
+
+                auto in_segment = [&](std::size_t city) {
+                    return std::find(segment, segment + len, city) != segment + len;
+                };
+
+                for (const std::size_t end: {first, last}) {
+                    for (const Neighbor& candidate: neighbors_[end]) {
+                        if (expired()) {
+                            return false;
+                        }
+                        if (candidate.distance >= removed) {
+                            break;
+                        }
+
+                        const std::size_t c = candidate.city;
+                        if (in_segment(c)) {
+                            continue;
+                        }
+
+                        for (int side = 0; side < 2; ++side) {
+                            const std::size_t other = (side == 0) ? tour_.next(c) : tour_.prev(c);
+                            if (in_segment(other)) {
+                                continue;
+                            }
+
+                            // Insert between a and its successor b, with end next to c.
+                            const std::size_t a = (side == 0) ? c : other;
+                            const std::size_t b = (side == 0) ? other : c;
+                            const bool reversed = (end == first) != (c == a);
+                            const std::int64_t added = reversed ? dist(a, last) + dist(first, b)
+                                                                : dist(a, first) + dist(last, b);
+
+                            const std::int64_t gain = removed + dist(a, b) - added;
+                            if (gain > 0) {
+                                tour_.move_segment(first, last, a, reversed);
+                                gain_ += gain;
+                                for (const std::size_t city: {prev, next, first, last, a, b}) {
+                                    activate(city);
+                                }
+                                return true;
+                            }
+                        }
+                    }
+
+                    if (len == 1) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    TourStore& tour_;
+    const Distance& distances_;
+    const NeighborLists& neighbors_;
+    const RunController* controller_;
+    std::size_t n_;
+
+    std::vector<char>& queued_;
+    std::vector<std::uint32_t>& active_;
+    std::size_t active_head_ = 0;
+    std::size_t active_count_ = 0;
+    std::int64_t gain_ = 0;
+    // The flips of the Lin-Kernighan move being built, one per level.
+    Flip flips_[LK_DEPTH] = {};
+    std::size_t flip_count_ = 0;
+};
+
+template <typename Distance>
+void check_local_search_sizes(const Tour& path, const Distance& distances, const NeighborLists& neighbors,
+                              const char* name) {
+    // name stays a literal until it is needed: a std::string would allocate on every call.
+    if (distances.size() != path.size() || neighbors.size() != path.size()) {
+        throw std::invalid_argument(std::string(name) + ": matrix or neighbor-list size does not match tour size.");
+    }
+}
+
+// Runs a NeighborSearch over tour with moves_to_try, leaves its gain in workspace and clears the
+// workspace's seeds.
+template <typename Distance, typename TourStore>
+std::size_t search_store(TourStore& tour, const std::uint32_t* order, const Distance& distances,
+                         const NeighborLists& neighbors, const RunController* controller, unsigned moves_to_try,
+                         std::size_t max_moves, LocalSearchWorkspace& workspace) {
+    NeighborSearch<Distance, TourStore> search(tour, order, distances, neighbors, controller, workspace);
+    const std::size_t moves = search.run(moves_to_try, max_moves);
+    workspace.gain = search.gain();
+
+    return moves;
 }
 
-std::mt19937 gen(DEFAULT_RANDOM_SEED);
+// Runs a NeighborSearch in workspace, or in a workspace of its own when none is given, and
+// clears the workspace's seeds.
+template <typename Distance>
+std::size_t run_neighbor_search(Tour& path, const Distance& distances, const NeighborLists& neighbors,
+                                const RunController* controller, unsigned moves_to_try, std::size_t max_moves,
+                                LocalSearchWorkspace* workspace) {
+    LocalSearchWorkspace own_workspace;
+    LocalSearchWorkspace& scratch = workspace ? *workspace : own_workspace;
+    std::size_t moves = 0;
+    scratch.gain = 0;
+
+    if (path.size() >= 4 && max_moves > 0) {
+        if (choose_tour_store(path.size(), tour_store_setting()) == TourStore::TwoLevel) {
+            TwoLevelTour& tour = scratch.two_level;
+            tour.assign(path);
+            moves = search_store(tour, path.data(), distances, neighbors, controller, moves_to_try, max_moves,
+                                 scratch);
+            tour.write(path);
+        }
+        else {
+            ArrayTour tour(path, scratch.positions);
+            moves = search_store(tour, path.data(), distances, neighbors, controller, moves_to_try, max_moves,
+                                 scratch);
+        }
+    }
+
+    scratch.seeds.clear();
+    return moves;
+}
+
+unsigned search_moves(LocalSearch kind) {
+    switch (kind) {
+        case LocalSearch::OrOpt:
+            return MOVE_TWO_OPT | MOVE_OR_OPT;
+        case LocalSearch::LinKernighan:
+            return MOVE_LIN_KERNIGHAN | MOVE_OR_OPT;
+        case LocalSearch::TwoOpt:
+            break;
+    }
+
+    return MOVE_TWO_OPT;
+}
 
-void set_random_seed(std::uint32_t seed) {
-    gen.seed(seed);
 }
 
 std::uint32_t derive_run_seed(std::uint32_t base_seed, std::uint32_t algorithm_id,
@@ -69,6 +558,33 @@ std::uint32_t derive_run_seed(std::uint32_t base_seed, std::uint32_t algorithm_i
     return seed;
 }
 
+Tour to_tour(const std::vector<City>& cities) {
+    Tour tour(cities.size());
+    for (std::size_t i = 0; i < cities.size(); ++i) {
+        tour[i] = static_cast<std::uint32_t>(cities[i].id - 1);
+    }
+
+    return tour;
+}
+
+std::vector<City> cities_by_index(const std::vector<City>& cities) {
+    std::vector<City> city_by_index(cities.size());
+    for (const auto& city: cities) {
+        city_by_index[static_cast<std::size_t>(city.id - 1)] = city;
+    }
+
+    return city_by_index;
+}
+
+std::vector<City> to_cities(const Tour& tour, const std::vector<City>& city_by_index) {
+    std::vector<City> cities(tour.size());
+    for (std::size_t i = 0; i < tour.size(); ++i) {
+        cities[i] = city_by_index[tour[i]];
+    }
+
+    return cities;
+}
+
 int tsplib_distance(const City& a, const City& b) {
     const double dx = a.point.first - b.point.first;
     const double dy = a.point.second - b.point.second;
@@ -108,32 +624,191 @@ bool is_valid_tour(const std::vector<City>& cities) {
     return true;
 }
 
-std::vector<double> build_distance_matrix(const std::vector<City>& cities) {
-    validate_tour_input(cities, "Distance matrix");
+std::int64_t max_distance_bound(const std::vector<City>& cities) {
+    if (cities.empty()) {
+        return 0;
+    }
 
-    const std::size_t n = cities.size();
+    auto [min_x, max_x] = std::pair{cities.front().point.first, cities.front().point.first};
+    auto [min_y, max_y] = std::pair{cities.front().point.second, cities.front().point.second};
+    for (const auto& city: cities) {
+        min_x = std::min(min_x, city.point.first);
+        max_x = std::max(max_x, city.point.first);
+        min_y = std::min(min_y, city.point.second);
+        max_y = std::max(max_y, city.point.second);
+    }
+
+    const double diagonal = std::floor(std::hypot(max_x - min_x, max_y - min_y) + 0.5);
+    if (!(diagonal < static_cast<double>(std::numeric_limits<std::int64_t>::max()))) {
+        return std::numeric_limits<std::int64_t>::max();
+    }
 
-    std::vector<double> distance_matrix(n * n, 0.0);
-    for (const auto& from: cities) {
-        const auto from_index = static_cast<std::size_t>(from.id - 1);
+    return static_cast<std::int64_t>(diagonal);
+}
 
-        for (const auto& to: cities) {
-            const auto to_index = static_cast<std::size_t>(to.id - 1);
-            if (from_index != to_index) {
-                distance_matrix[matrix_index(from_index, to_index, n)] = tsplib_distance(from, to);
+template <typename T>
+DistanceMatrix<T> build_distance_matrix_as(const std::vector<City>& cities) {
+    const CoordinateDistance coordinates = coordinates_for_matrix<T>(cities, "Distance matrix");
+    const std::size_t n = coordinates.size();
+
+    const std::size_t chunks = (n + DENSE_ROW_CHUNK - 1) / DENSE_ROW_CHUNK;
+    const double* x = coordinates.x().data();
+    const double* y = coordinates.y().data();
+
+    // Every row is computed in full, filling both triangles in one pass: twice the arithmetic of
+    // mirroring i < j, but all stores are sequential, which is what bounds this loop.
+    DistanceMatrix<T> distance_matrix(n);
+    parallel_tasks(chunks, [&](std::size_t chunk) {
+        std::vector<std::int32_t> distances(std::is_same_v<T, std::int32_t> ? 0 : n);
+        const std::size_t row_end = std::min(n, (chunk + 1) * DENSE_ROW_CHUNK);
+
+        for (std::size_t i = chunk * DENSE_ROW_CHUNK; i < row_end; ++i) {
+            if constexpr (std::is_same_v<T, std::int32_t>) {
+                euc2d_distances(x, y, x[i], y[i], n, distance_matrix.row(i));
+            }
+            else {
+                euc2d_distances(x, y, x[i], y[i], n, distances.data());
+                std::copy(distances.begin(), distances.end(), distance_matrix.row(i));
             }
         }
-    }
+    });
 
     return distance_matrix;
 }
 
-double total_cost(const std::vector<City>& cities) {
+template <typename T>
+PackedDistanceMatrix<T> build_packed_distance_matrix_as(const std::vector<City>& cities) {
+    const CoordinateDistance coordinates = coordinates_for_matrix<T>(cities, "Packed distance matrix");
+    const std::size_t n = coordinates.size();
+
+    const std::size_t chunks = (n + PACKED_COLUMN_CHUNK - 1) / PACKED_COLUMN_CHUNK;
+    const double* x = coordinates.x().data();
+    const double* y = coordinates.y().data();
+
+    // Chunks run from the longest columns down to balance the threads.
+    PackedDistanceMatrix<T> distance_matrix(n);
+    parallel_tasks(chunks, [&](std::size_t chunk) {
+        const std::size_t last = n - chunk * PACKED_COLUMN_CHUNK;
+        const std::size_t first = last > PACKED_COLUMN_CHUNK ? last - PACKED_COLUMN_CHUNK : 0;
+        std::vector<std::int32_t> distances(std::is_same_v<T, std::int32_t> ? 0 : last);
+
+        for (std::size_t j = first; j < last; ++j) {
+            T* column = distance_matrix.column(j);
+
+            if constexpr (std::is_same_v<T, std::int32_t>) {
+                euc2d_distances(x, y, x[j], y[j], j, column);
+            }
+            else {
+                euc2d_distances(x, y, x[j], y[j], j, distances.data());
+                std::copy(distances.begin(), distances.begin() + static_cast<std::ptrdiff_t>(j), column);
+            }
+        }
+    });
+
+    return distance_matrix;
+}
+
+template DistanceMatrix<std::uint16_t> build_distance_matrix_as(const std::vector<City>&);
+template DistanceMatrix<std::int32_t> build_distance_matrix_as(const std::vector<City>&);
+template PackedDistanceMatrix<std::uint16_t> build_packed_distance_matrix_as(const std::vector<City>&);
+template PackedDistanceMatrix<std::int32_t> build_packed_distance_matrix_as(const std::vector<City>&);
+
+DistanceMatrix<std::int32_t> build_distance_matrix(const std::vector<City>& cities) {
+    return build_distance_matrix_as<std::int32_t>(cities);
+}
+
+CoordinateDistance build_coordinate_distance(const std::vector<City>& cities) {
+    return coordinates_for_matrix<std::int32_t>(cities, "Coordinate distance");
+}
+
+std::size_t distance_budget_bytes() {
+    const char* env = std::getenv("TSP_DISTANCE_BUDGET_MB");
+    if (env == nullptr || *env == '\0') {
+        return DEFAULT_DISTANCE_BUDGET_BYTES;
+    }
+
+    char* end = nullptr;
+    const unsigned long long megabytes = std::strtoull(env, &end, 10);
+    if (*end != '\0' || megabytes > std::numeric_limits<std::size_t>::max() / (std::size_t{1} << 20)) {
+        throw std::runtime_error(std::string("Invalid TSP_DISTANCE_BUDGET_MB: ") + env);
+    }
+
+    return static_cast<std::size_t>(megabytes) << 20;
+}
+
+DistanceStorage distance_storage_setting() {
+    const char* env = std::getenv("TSP_DISTANCE_STORAGE");
+    if (env == nullptr || *env == '\0') {
+        return DistanceStorage::Auto;
+    }
+
+    const std::string value = env;
+    if (value == "auto") {
+        return DistanceStorage::Auto;
+    }
+    if (value == "dense") {
+        return DistanceStorage::Dense;
+    }
+    if (value == "packed") {
+        return DistanceStorage::Packed;
+    }
+    if (value == "coordinates") {
+        return DistanceStorage::Coordinates;
+    }
+
+    throw std::runtime_error("Invalid TSP_DISTANCE_STORAGE (expected auto, dense, packed or coordinates): " + value);
+}
+
+TourStore tour_store_setting() {
+    const char* env = std::getenv("TSP_TOUR_STORE");
+    if (env == nullptr || *env == '\0') {
+        return TourStore::Auto;
+    }
+
+    const std::string value = env;
+    if (value == "auto") {
+        return TourStore::Auto;
+    }
+    if (value == "array") {
+        return TourStore::Array;
+    }
+    if (value == "two_level") {
+        return TourStore::TwoLevel;
+    }
+
+    throw std::runtime_error("Invalid TSP_TOUR_STORE (expected auto, array or two_level): " + value);
+}
+
+TourStore choose_tour_store(std::size_t n, TourStore requested) {
+    if (requested != TourStore::Auto) {
+        return requested;
+    }
+
+    return n >= TWO_LEVEL_TOUR_MIN_CITIES ? TourStore::TwoLevel : TourStore::Array;
+}
+
+DistanceStorage choose_distance_storage(std::size_t n, std::size_t element_bytes, std::size_t pair_bytes,
+                                        std::size_t budget_bytes, DistanceStorage requested) {
+    if (requested != DistanceStorage::Auto) {
+        return requested;
+    }
+
+    const std::size_t bytes_per_pair = element_bytes + pair_bytes;
+    const std::size_t pairs = n / 2 * (n + 1) + (n % 2) * ((n + 1) / 2);
+
+    if (bytes_per_pair == 0 || pairs <= budget_bytes / bytes_per_pair) {
+        return DistanceStorage::Packed;
+    }
+
+    return DistanceStorage::Coordinates;
+}
+
+std::int64_t total_cost(const std::vector<City>& cities) {
     if (cities.size() < 2) {
-        return 0.0;
+        return 0;
     }
 
-    double total = 0.0;
+    std::int64_t total = 0;
     for (std::size_t i = 1; i < cities.size(); ++i) {
         total += tsplib_distance(cities[i - 1], cities[i]);
     }
@@ -143,214 +818,201 @@ double total_cost(const std::vector<City>& cities) {
     return total;
 }
 
-double total_cost(const std::vector<City>& cities, const std::vector<double>& distance_matrix) {
+template <typename Distance>
+std::int64_t total_cost(const std::vector<City>& cities, const Distance& distances) {
     const std::size_t n = cities.size();
 
     if (n < 2) {
-        return 0.0;
+        return 0;
     }
-    if (distance_matrix.size() != n * n) {
+    if (distances.size() != n) {
         throw std::invalid_argument("Distance matrix size does not match tour size.");
     }
     validate_tour_input(cities, "Matrix tour cost");
 
-    return total_cost_unchecked(cities, distance_matrix);
+    return total_cost_unchecked(to_tour(cities), distances);
 }
 
-double total_cost_unchecked(const std::vector<City>& cities, const std::vector<double>& distance_matrix) {
-    const std::size_t n = cities.size();
+template <typename Distance>
+std::int64_t total_cost_unchecked(const Tour& tour, const Distance& distances) {
+    const std::size_t n = tour.size();
 
     if (n < 2) {
-        return 0.0;
+        return 0;
     }
 
-    double total = 0.0;
+    std::int64_t total = 0;
     for (std::size_t i = 1; i < n; ++i) {
-        const auto previous_id = static_cast<std::size_t>(cities[i - 1].id - 1);
-        const auto current_id = static_cast<std::size_t>(cities[i].id - 1);
-        total += distance_matrix[matrix_index(previous_id, current_id, n)];
+        total += distances(tour[i - 1], tour[i]);
     }
 
-    const auto last_id = static_cast<std::size_t>(cities[n - 1].id - 1);
-    const auto first_id = static_cast<std::size_t>(cities[0].id - 1);
-
-    total += distance_matrix[matrix_index(last_id, first_id, n)];
+    total += distances(tour[n - 1], tour[0]);
 
     return total;
 }
 
-std::vector<std::vector<std::size_t>> build_neighbor_lists(const std::vector<double>& distance_matrix, std::size_t n, std::size_t k) {
-    if (distance_matrix.size() != n * n) {
+template <typename Distance>
+NeighborLists build_neighbor_lists(const Distance& distances, std::size_t n, std::size_t k) {
+    if (distances.size() != n) {
         throw std::invalid_argument("build_neighbor_lists: distance matrix size does not match city count.");
     }
 
-    std::vector<std::vector<std::size_t>> neighbors(n);
+    NeighborLists neighbors;
     if (n < 2) {
+        for (std::size_t city = 0; city < n; ++city) {
+            neighbors.append(nullptr, nullptr);
+        }
         return neighbors;
     }
 
     const std::size_t limit = std::min(k, n - 1);
+    neighbors.reserve(n, n * limit);
 
+    std::vector<Neighbor> others(n - 1);
     for (std::size_t city = 0; city < n; ++city) {
-        std::vector<std::size_t> others;
-
-        others.reserve(n - 1);
-
+        std::size_t count = 0;
         for (std::size_t other = 0; other < n; ++other) {
             if (other != city) {
-                others.push_back(other);
+                others[count++] = {static_cast<std::uint32_t>(other), static_cast<std::int32_t>(distances(city, other))};
             }
         }
 
         std::partial_sort(others.begin(), others.begin() + static_cast<std::ptrdiff_t>(limit), others.end(),
-                          [&](std::size_t lhs, std::size_t rhs) {
-            return distance_matrix[matrix_index(city, lhs, n)] < distance_matrix[matrix_index(city, rhs, n)];
+                          [](const Neighbor& lhs, const Neighbor& rhs) {
+            return lhs.distance != rhs.distance ? lhs.distance < rhs.distance : lhs.city < rhs.city;
         });
 
-        others.resize(limit);
-        neighbors[city] = std::move(others);
+        neighbors.append(others.data(), others.data() + limit);
     }
 
     return neighbors;
 }
 
-std::size_t two_opt_neighbors(std::vector<City>& path, const std::vector<double>& distance_matrix,
-                              const std::vector<std::vector<std::size_t>>& neighbors, std::size_t max_moves,
+template <typename Distance>
+std::size_t two_opt_neighbors(std::vector<City>& path, const Distance& distances,
+                              const NeighborLists& neighbors, std::size_t max_moves,
                               const RunController* controller) {
     validate_tour_input(path, "Two-opt");
 
-    return two_opt_neighbors_unchecked(path, distance_matrix, neighbors, max_moves, controller);
-}
-
-std::size_t two_opt_neighbors_unchecked(std::vector<City>& path, const std::vector<double>& distance_matrix,
-                                        const std::vector<std::vector<std::size_t>>& neighbors,
-                                        std::size_t max_moves, const RunController* controller) {
-    const std::size_t n = path.size();
+    Tour tour = to_tour(path);
+    const std::size_t moves = two_opt_neighbors_unchecked(tour, distances, neighbors, max_moves, controller);
 
-    if (distance_matrix.size() != n * n || neighbors.size() != n) {
-        throw std::invalid_argument("two_opt_neighbors: matrix or neighbor-list size does not match tour size.");
-    }
-    if (n < 4 || max_moves == 0) {
-        return 0;
-    }
+    path = to_cities(tour, cities_by_index(path));
+    return moves;
+}
 
-    auto dist = [&](std::size_t a, std::size_t b) -> double {
-        return distance_matrix[matrix_index(a, b, n)];
-    };
+template <typename Distance>
+std::size_t two_opt_neighbors_unchecked(Tour& path, const Distance& distances,
+                                        const NeighborLists& neighbors,
+                                        std::size_t max_moves, const RunController* controller,
+                                        LocalSearchWorkspace* workspace) {
+    check_local_search_sizes(path, distances, neighbors, "two_opt_neighbors");
 
-    std::vector<std::size_t> pos(n);
-    for (std::size_t i = 0; i < n; ++i) {
-        pos[static_cast<std::size_t>(path[i].id - 1)] = i;
-    }
-
-    auto reverse_arc = [&](std::size_t i, std::size_t j) {
-        std::size_t len = (j >= i) ? (j - i + 1) : (n - i + j + 1);
-        if (len > n - len) {
-            const std::size_t ni = (j + 1) % n;
-            const std::size_t nj = (i + n - 1) % n;
-            i = ni;
-            j = nj;
-            len = n - len;
-        }
-        std::size_t a = i;
-        std::size_t b = j;
-        for (std::size_t s = 0; s < len / 2; ++s) {
-            std::swap(path[a], path[b]);
-            pos[static_cast<std::size_t>(path[a].id - 1)] = a;
-            pos[static_cast<std::size_t>(path[b].id - 1)] = b;
-            a = (a + 1) % n;
-            b = (b + n - 1) % n;
-        }
-    };
+    return run_neighbor_search(path, distances, neighbors, controller, MOVE_TWO_OPT, max_moves, workspace);
+}
 
-    std::queue<std::size_t> active;
+template <typename Distance>
+std::size_t or_opt_neighbors_unchecked(Tour& path, const Distance& distances, const NeighborLists& neighbors,
+                                       std::size_t max_moves, const RunController* controller,
+                                       LocalSearchWorkspace* workspace) {
+    check_local_search_sizes(path, distances, neighbors, "or_opt_neighbors");
 
-    std::vector<char> queued(n, 1);
-    for (std::size_t i = 0; i < n; ++i) {
-        active.push(static_cast<std::size_t>(path[i].id - 1));
-    }
+    return run_neighbor_search(path, distances, neighbors, controller, MOVE_OR_OPT, max_moves, workspace);
+}
 
-    std::size_t moves = 0;
-    constexpr double eps = 1e-9;
-
-    while (!active.empty() && moves < max_moves && !(controller && controller->time_expired())) {
-        const std::size_t c1 = active.front();
-        active.pop();
-        queued[c1] = 0;
-
-        bool improved = false;
-        for (int dir = 0; dir < 2 && !improved && !(controller && controller->time_expired()); ++dir) {
-            const std::size_t p1 = pos[c1];
-            const std::size_t p2 = (dir == 0) ? (p1 + 1) % n : (p1 + n - 1) % n;
-            const std::size_t c2 = static_cast<std::size_t>(path[p2].id - 1);
-            const double d_c1c2 = dist(c1, c2);
-
-            for (const std::size_t c3: neighbors[c1]) {
-                if (controller && controller->time_expired()) {
-                    break;
-                }
+template <typename Distance>
+std::size_t two_opt_or_opt_neighbors_unchecked(Tour& path, const Distance& distances,
+                                               const NeighborLists& neighbors, std::size_t max_moves,
+                                               const RunController* controller, LocalSearchWorkspace* workspace) {
+    check_local_search_sizes(path, distances, neighbors, "two_opt_or_opt_neighbors");
 
-                const double d_c1c3 = dist(c1, c3);
-                if (d_c1c3 >= d_c1c2) {
-                    break;
-                }
+    return run_neighbor_search(path, distances, neighbors, controller, MOVE_TWO_OPT | MOVE_OR_OPT, max_moves, workspace);
+}
 
-                const std::size_t p3 = pos[c3];
-                const std::size_t p4 = (dir == 0) ? (p3 + 1) % n : (p3 + n - 1) % n;
-                const std::size_t c4 = static_cast<std::size_t>(path[p4].id - 1);
+template <typename Distance>
+std::size_t lin_kernighan_neighbors_unchecked(Tour& path, const Distance& distances,
+                                              const NeighborLists& neighbors, std::size_t max_moves,
+                                              const RunController* controller, LocalSearchWorkspace* workspace) {
+    check_local_search_sizes(path, distances, neighbors, "lin_kernighan_neighbors");
 
-                if (c4 == c1) {
-                    continue;
-                }
+    return run_neighbor_search(path, distances, neighbors, controller, MOVE_LIN_KERNIGHAN | MOVE_OR_OPT, max_moves, workspace);
+}
 
-                const double gain = d_c1c2 + dist(c3, c4) - d_c1c3 - dist(c2, c4);
+template <typename Distance>
+std::size_t array_local_search_unchecked(std::uint32_t* tour, std::uint32_t* positions, std::size_t n,
+                                         const Distance& distances, const NeighborLists& neighbors, LocalSearch kind,
+                                         std::size_t max_moves, const RunController* controller,
+                                         LocalSearchWorkspace& workspace) {
+    std::size_t moves = 0;
+    workspace.gain = 0;
 
-                if (gain > eps) {
-                    if (dir == 0) {
-                        reverse_arc(p2, p3);
-                    } else {
-                        reverse_arc(p3, p2);
-                    }
-                    for (const std::size_t c: {c1, c2, c3, c4}) {
-                        if (!queued[c]) {
-                            queued[c] = 1;
-                            active.push(c);
-                        }
-                    }
-                    ++moves;
-                    improved = true;
-                    break;
-                }
-            }
-        }
+    if (n >= 4 && max_moves > 0) {
+        ArrayTour array(tour, positions, n);
+        moves = search_store(array, tour, distances, neighbors, controller, search_moves(kind), max_moves, workspace);
     }
 
+    workspace.seeds.clear();
     return moves;
 }
 
+#define TSP_INSTANTIATE_DISTANCE_KERNELS(Distance)                                                           \
+    template std::int64_t total_cost(const std::vector<City>&, const Distance&);                               \
+    template std::int64_t total_cost_unchecked(const Tour&, const Distance&);                                  \
+    template NeighborLists build_neighbor_lists(const Distance&, std::size_t, std::size_t);                    \
+    template std::size_t two_opt_neighbors(std::vector<City>&, const Distance&, const NeighborLists&,          \
+                                           std::size_t, const RunController*);                                 \
+    template std::size_t two_opt_neighbors_unchecked(Tour&, const Distance&, const NeighborLists&,              \
+                                                     std::size_t, const RunController*,                        \
+                                                     LocalSearchWorkspace*);                                   \
+    template std::size_t or_opt_neighbors_unchecked(Tour&, const Distance&, const NeighborLists&,               \
+                                                    std::size_t, const RunController*,                         \
+                                                    LocalSearchWorkspace*);                                    \
+    template std::size_t two_opt_or_opt_neighbors_unchecked(Tour&, const Distance&, const NeighborLists&,       \
+                                                            std::size_t, const RunController*,                 \
+                                                            LocalSearchWorkspace*);                            \
+    template std::size_t lin_kernighan_neighbors_unchecked(Tour&, const Distance&, const NeighborLists&,        \
+                                                           std::size_t, const RunController*,                  \
+                                                           LocalSearchWorkspace*);                              \
+    template std::size_t array_local_search_unchecked(std::uint32_t*, std::uint32_t*, std::size_t,              \
+                                                      const Distance&, const NeighborLists&, LocalSearch,       \
+                                                      std::size_t, const RunController*, LocalSearchWorkspace&);
+
+TSP_INSTANTIATE_DISTANCE_KERNELS(DistanceMatrix<std::uint16_t>)
+TSP_INSTANTIATE_DISTANCE_KERNELS(DistanceMatrix<std::int32_t>)
+TSP_INSTANTIATE_DISTANCE_KERNELS(PackedDistanceMatrix<std::uint16_t>)
+TSP_INSTANTIATE_DISTANCE_KERNELS(PackedDistanceMatrix<std::int32_t>)
+TSP_INSTANTIATE_DISTANCE_KERNELS(CoordinateDistance)
+
+#undef TSP_INSTANTIATE_DISTANCE_KERNELS
+
 void readfile(std::vector<City>& cities, const std::string& filename) {
-    std::ifstream file(filename);
+    const MappedFile file(filename);
 
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open TSPLIB file: " + filename);
-    }
+    parse_tsplib(cities, file.text(), filename);
+}
+
+void parse_tsplib(std::vector<City>& cities, std::string_view text, const std::string& filename) {
+    std::string_view rest = text;
 
-    std::string line;
+    std::string_view line;
     bool reading_coords = false;
     bool found_coord_section = false;
     int dimension = -1;
     std::string edge_weight_type;
     std::vector<City> parsed_cities;
-    std::unordered_set<int> used_ids;
 
-    while (std::getline(file, line)) {
-        const std::string stripped = trim_line(line);
+    while (next_line(rest, line)) {
+        const std::string_view stripped = trim_view(line);
         if (stripped.empty()) {
             continue;
         }
         if (stripped == "NODE_COORD_SECTION") {
             reading_coords = true;
             found_coord_section = true;
+            if (dimension > 0) {
+                // A coordinate line takes at least six bytes ("1 0 0\n"), which bounds a bogus DIMENSION.
+                parsed_cities.reserve(std::min(static_cast<std::size_t>(dimension), rest.size() / 6 + 1));
+            }
             continue;
         }
         if (stripped == "EOF") {
@@ -358,24 +1020,23 @@ void readfile(std::vector<City>& cities, const std::string& filename) {
         }
 
         if (reading_coords) {
-            std::istringstream iss(stripped);
+            std::string_view fields = stripped;
             City c{};
-            if (!(iss >> c.id >> c.point.first >> c.point.second)) {
-                throw std::runtime_error("Invalid coordinate line in " + filename + ": " + line);
+            if (!parse_field(fields, c.id) || !parse_field(fields, c.point.first) ||
+                !parse_field(fields, c.point.second)) {
+                throw std::runtime_error("Invalid coordinate line in " + filename + ": " + std::string(line));
             }
-            std::string trailing;
-            if (iss >> trailing) {
-                throw std::runtime_error("Unexpected trailing coordinate data in " + filename + ": " + line);
-            }
-            if (!used_ids.insert(c.id).second) {
-                throw std::runtime_error("Duplicate city id in " + filename + ": " + std::to_string(c.id));
+            if (!trim_view(fields).empty()) {
+                throw std::runtime_error("Unexpected trailing coordinate data in " + filename + ": " +
+                                         std::string(line));
             }
             parsed_cities.push_back(c);
             continue;
         }
 
+        const std::string header(line);
         std::string value;
-        if (parse_tsplib_field(line, "DIMENSION", value)) {
+        if (parse_tsplib_field(header, "DIMENSION", value)) {
             try {
                 std::size_t used = 0;
                 dimension = std::stoi(value, &used);
@@ -387,11 +1048,19 @@ void readfile(std::vector<City>& cities, const std::string& filename) {
                 throw std::runtime_error("Invalid DIMENSION in " + filename + ": " + value);
             }
         }
-        else if (parse_tsplib_field(line, "EDGE_WEIGHT_TYPE", value)) {
+        else if (parse_tsplib_field(header, "EDGE_WEIGHT_TYPE", value)) {
             edge_weight_type = value;
         }
     }
 
+    // Sorting first lets duplicates be found between neighbors instead of through a hash set.
+    std::sort(parsed_cities.begin(), parsed_cities.end());
+    const auto duplicate = std::adjacent_find(parsed_cities.begin(), parsed_cities.end(),
+                                              [](const City& a, const City& b) { return a.id == b.id; });
+    if (duplicate != parsed_cities.end()) {
+        throw std::runtime_error("Duplicate city id in " + filename + ": " + std::to_string(duplicate->id));
+    }
+
     if (dimension <= 0) {
         throw std::runtime_error("Missing or invalid DIMENSION in TSPLIB file: " + filename);
     }
@@ -409,14 +1078,14 @@ void readfile(std::vector<City>& cities, const std::string& filename) {
                                  " cities, parsed " + std::to_string(parsed_cities.size()));
     }
 
-    for (const auto& city: parsed_cities) {
-        if (city.id < 1 || city.id > dimension) {
+    // Ids are sorted and distinct, so checking both ends covers every city.
+    for (const City* city: {&parsed_cities.front(), &parsed_cities.back()}) {
+        if (city->id < 1 || city->id > dimension) {
             throw std::runtime_error("City id out of supported range 1..DIMENSION in " + filename + ": " +
-                                     std::to_string(city.id));
+                                     std::to_string(city->id));
         }
     }
 
-    std::sort(parsed_cities.begin(), parsed_cities.end());
     cities = std::move(parsed_cities);
 }
 
@@ -457,6 +1126,9 @@ double RunController::elapsed() const {
     if (!timer_started_) {
         return 0.0;
     }
+    if (stop_.clock) {
+        return stop_.clock();
+    }
 
     return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count();
 }
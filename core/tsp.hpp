@@ -6,15 +6,16 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
-#include <random>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-inline constexpr std::uint32_t DEFAULT_RANDOM_SEED = 42;
-
-extern std::mt19937 gen;
-void set_random_seed(std::uint32_t seed);
+#include "coordinate_distance.hpp"
+#include "distance_matrix.hpp"
+#include "neighbor_lists.hpp"
+#include "rng.hpp"
+#include "triangular_matrix.hpp"
 
 std::uint32_t derive_run_seed(std::uint32_t base_seed, std::uint32_t algorithm_id,
                               std::size_t dataset_index, std::size_t repeat_index);
@@ -27,30 +28,147 @@ struct City {
     bool operator==(const City& other) const { return id == other.id && point == other.point; }
 };
 
+// A tour as a permutation of city indices (id - 1): 4 bytes per city instead of a 24-byte City,
+// so reversals, swaps and copies move a sixth of the memory. Solvers work on Tours internally and
+// convert at their *_solve boundary.
+using Tour = std::vector<std::uint32_t>;
+
+Tour to_tour(const std::vector<City>& cities);
+// Cities indexed by id - 1; expects ids 1..n as validate_tour_input checks.
+std::vector<City> cities_by_index(const std::vector<City>& cities);
+std::vector<City> to_cities(const Tour& tour, const std::vector<City>& city_by_index);
+
 int tsplib_distance(const City& a, const City& b);
 void validate_tour_input(const std::vector<City>& cities, const std::string& algorithm_name);
 bool is_valid_tour(const std::vector<City>& cities);
 
-std::vector<double> build_distance_matrix(const std::vector<City>& cities);
+// Upper bound on every rounded distance between two of the cities: the bounding-box diagonal.
+std::int64_t max_distance_bound(const std::vector<City>& cities);
+
+template <typename T>
+using PackedDistanceMatrix = TriangularMatrix<T>;
+
+template <typename T>
+DistanceMatrix<T> build_distance_matrix_as(const std::vector<City>& cities);
+template <typename T>
+PackedDistanceMatrix<T> build_packed_distance_matrix_as(const std::vector<City>& cities);
+DistanceMatrix<std::int32_t> build_distance_matrix(const std::vector<City>& cities);
+CoordinateDistance build_coordinate_distance(const std::vector<City>& cities);
+
+enum class DistanceStorage {
+    Auto,
+    Dense,
+    Packed,
+    Coordinates
+};
 
-double total_cost(const std::vector<City>& cities);
-double total_cost(const std::vector<City>& cities, const std::vector<double>& distance_matrix);
-double total_cost_unchecked(const std::vector<City>& cities, const std::vector<double>& distance_matrix);
+inline constexpr std::size_t DEFAULT_DISTANCE_BUDGET_BYTES = std::size_t{1} << 30;
+
+// Memory allowed for n x n solver structures; TSP_DISTANCE_BUDGET_MB overrides the 1 GiB default.
+std::size_t distance_budget_bytes();
+// Storage requested through TSP_DISTANCE_STORAGE (auto, dense, packed or coordinates); auto by default.
+DistanceStorage distance_storage_setting();
+
+// Resolves Auto to the storage the budget allows: packed triangular distances while they fit,
+// then coordinates. pair_bytes is caller-owned state per unordered city pair.
+DistanceStorage choose_distance_storage(std::size_t n, std::size_t element_bytes, std::size_t pair_bytes,
+                                        std::size_t budget_bytes, DistanceStorage requested);
+
+// Tour representation local search works on: an array with a position index, or a
+// TwoLevelTour whose reversals cost O(sqrt(n)) instead of O(n).
+enum class TourStore {
+    Auto,
+    Array,
+    TwoLevel
+};
+
+// Auto picks TwoLevel from this many cities on.
+inline constexpr std::size_t TWO_LEVEL_TOUR_MIN_CITIES = 2000;
+
+// Store requested through TSP_TOUR_STORE (auto, array or two_level); auto by default.
+TourStore tour_store_setting();
+TourStore choose_tour_store(std::size_t n, TourStore requested);
+
+template <typename T, typename Fn>
+decltype(auto) visit_distance_matrix(const std::vector<City>& cities, Fn&& fn, DistanceStorage storage) {
+    if (storage == DistanceStorage::Dense) {
+        return fn(build_distance_matrix_as<T>(cities));
+    }
+    if (storage == DistanceStorage::Packed) {
+        return fn(build_packed_distance_matrix_as<T>(cities));
+    }
+
+    return fn(build_coordinate_distance(cities));
+}
+
+// Builds the distance storage chosen for cities and passes it to fn: the narrowest matrix
+// element type able to hold every distance, or a matrix-free CoordinateDistance when the matrix
+// plus pair_bytes of caller-owned state per city pair would exceed the budget.
+template <typename Fn>
+decltype(auto) visit_distances(const std::vector<City>& cities, Fn&& fn, std::size_t pair_bytes = 0) {
+    const bool compact = max_distance_bound(cities) <= std::numeric_limits<std::uint16_t>::max();
+    const DistanceStorage storage =
+        choose_distance_storage(cities.size(), compact ? sizeof(std::uint16_t) : sizeof(std::int32_t), pair_bytes,
+                                distance_budget_bytes(), distance_storage_setting());
+
+    if (compact) {
+        return visit_distance_matrix<std::uint16_t>(cities, fn, storage);
+    }
+
+    return visit_distance_matrix<std::int32_t>(cities, fn, storage);
+}
+
+std::int64_t total_cost(const std::vector<City>& cities);
+template <typename Distance>
+std::int64_t total_cost(const std::vector<City>& cities, const Distance& distances);
+template <typename Distance>
+std::int64_t total_cost_unchecked(const Tour& tour, const Distance& distances);
 
 void readfile(std::vector<City>& cities, const std::string& filename);
+// readfile on contents already in memory; filename only labels error messages.
+void parse_tsplib(std::vector<City>& cities, std::string_view text, const std::string& filename);
 
 class RunController;
+struct LocalSearchWorkspace;
 
-std::vector<std::vector<std::size_t>> build_neighbor_lists(const std::vector<double>& distance_matrix,
-                                                           std::size_t n, std::size_t k);
+// k nearest cities of every city; equal distances are ordered by city index.
+template <typename Distance>
+NeighborLists build_neighbor_lists(const Distance& distances, std::size_t n, std::size_t k);
 
-std::size_t two_opt_neighbors(std::vector<City>& tour, const std::vector<double>& distance_matrix,
-                              const std::vector<std::vector<std::size_t>>& neighbors, std::size_t max_moves,
+template <typename Distance>
+std::size_t two_opt_neighbors(std::vector<City>& tour, const Distance& distances,
+                              const NeighborLists& neighbors, std::size_t max_moves,
                               const RunController* controller = nullptr);
 
-std::size_t two_opt_neighbors_unchecked(std::vector<City>& tour, const std::vector<double>& distance_matrix,
-                                        const std::vector<std::vector<std::size_t>>& neighbors,
-                                        std::size_t max_moves, const RunController* controller = nullptr);
+// The *_neighbors_unchecked searches take an optional LocalSearchWorkspace (local_search.hpp):
+// its buffers are reused across calls and its seeds limit where the search starts.
+template <typename Distance>
+std::size_t two_opt_neighbors_unchecked(Tour& tour, const Distance& distances,
+                                        const NeighborLists& neighbors,
+                                        std::size_t max_moves, const RunController* controller = nullptr,
+                                        LocalSearchWorkspace* workspace = nullptr);
+
+// Or-opt: moves segments of 1 to 3 cities next to one of their candidate neighbors, a move 2-opt
+// cannot express. Same active-queue and neighbor-list search as two_opt_neighbors_unchecked.
+template <typename Distance>
+std::size_t or_opt_neighbors_unchecked(Tour& tour, const Distance& distances, const NeighborLists& neighbors,
+                                       std::size_t max_moves, const RunController* controller = nullptr,
+                                       LocalSearchWorkspace* workspace = nullptr);
+
+// 2-opt and Or-opt from one active queue: each city tries 2-opt moves first, then Or-opt moves.
+template <typename Distance>
+std::size_t two_opt_or_opt_neighbors_unchecked(Tour& tour, const Distance& distances,
+                                               const NeighborLists& neighbors, std::size_t max_moves,
+                                               const RunController* controller = nullptr,
+                                               LocalSearchWorkspace* workspace = nullptr);
+
+// Lin-Kernighan style variable-depth search: sequential moves of up to five flips (5-opt), with
+// a few alternatives at the first two levels, followed by Or-opt moves for each active city.
+template <typename Distance>
+std::size_t lin_kernighan_neighbors_unchecked(Tour& tour, const Distance& distances,
+                                              const NeighborLists& neighbors, std::size_t max_moves,
+                                              const RunController* controller = nullptr,
+                                              LocalSearchWorkspace* workspace = nullptr);
 
 enum class StopReason {
     None,
@@ -70,6 +188,10 @@ struct StopCondition {
 
     std::size_t progress_interval = 0;
     std::function<void(std::size_t, double)> progress_callback;
+
+    // Seconds since the run started, in place of the steady clock for max_seconds and deadlines.
+    // Tests set it to pace a run by work done instead of wall time; it may be called from any thread.
+    std::function<double()> clock;
 };
 
 StopCondition time_limit(double seconds);
@@ -84,6 +206,11 @@ struct SolveResult {
     StopReason stop_reason = StopReason::None;
 
     std::size_t restarts = 0;
+    // Construction steps whose candidate list had no unvisited city and fell back to a full scan.
+    std::size_t fallbacks = 0;
+    // SA: tour cities its lazy best-tour tracking did not copy, against copying the whole tour on
+    // every new best.
+    std::size_t saved_copy_cities = 0;
 };
 
 class RunController {
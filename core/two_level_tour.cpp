@@ -0,0 +1,213 @@
+#include "two_level_tour.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TwoLevelTour::TwoLevelTour(const Tour& tour) {
+    assign(tour);
+}
+
+void TwoLevelTour::assign(const Tour& tour) {
+    const std::size_t n = tour.size();
+
+    segment_length_ = std::max<std::size_t>(8, static_cast<std::size_t>(std::sqrt(static_cast<double>(n))));
+    city_segment_.resize(n);
+    city_slot_.resize(n);
+    cities_.assign(tour.begin(), tour.end());
+    rebuild();
+}
+
+void TwoLevelTour::rebuild() {
+    const std::size_t n = cities_.size();
+    const std::size_t count = (n + segment_length_ - 1) / segment_length_;
+
+    if (segments_.size() < count) {
+        segments_.resize(count);
+    }
+    order_.resize(count);
+
+    for (std::size_t id = 0; id < count; ++id) {
+        Segment& segment = segments_[id];
+        const std::size_t start = id * segment_length_;
+        segment.cities.assign(cities_.begin() + static_cast<std::ptrdiff_t>(start),
+                              cities_.begin() + static_cast<std::ptrdiff_t>(std::min(n, start + segment_length_)));
+        segment.reversed = false;
+        segment.rank = id;
+        order_[id] = id;
+
+        for (std::size_t slot = 0; slot < segment.cities.size(); ++slot) {
+            city_segment_[segment.cities[slot]] = static_cast<std::uint32_t>(id);
+            city_slot_[segment.cities[slot]] = static_cast<std::uint32_t>(slot);
+        }
+    }
+}
+
+std::size_t TwoLevelTour::index_in_segment(std::size_t city) const {
+    const Segment& segment = segments_[city_segment_[city]];
+    const std::size_t slot = city_slot_[city];
+
+    return segment.reversed ? segment.cities.size() - 1 - slot : slot;
+}
+
+std::uint32_t TwoLevelTour::city_at(const Segment& segment, std::size_t index) const {
+    return segment.cities[segment.reversed ? segment.cities.size() - 1 - index : index];
+}
+
+std::size_t TwoLevelTour::next(std::size_t city) const {
+    const Segment& segment = segments_[city_segment_[city]];
+    const std::size_t index = index_in_segment(city);
+
+    if (index + 1 < segment.cities.size()) {
+        return city_at(segment, index + 1);
+    }
+
+    return city_at(segments_[order_[(segment.rank + 1) % order_.size()]], 0);
+}
+
+std::size_t TwoLevelTour::prev(std::size_t city) const {
+    const Segment& segment = segments_[city_segment_[city]];
+    const std::size_t index = index_in_segment(city);
+
+    if (index > 0) {
+        return city_at(segment, index - 1);
+    }
+
+    const Segment& before = segments_[order_[(segment.rank + order_.size() - 1) % order_.size()]];
+    return city_at(before, before.cities.size() - 1);
+}
+
+bool TwoLevelTour::between(std::size_t a, std::size_t b, std::size_t c) const {
+    auto key = [&](std::size_t city) {
+        return std::make_pair(segments_[city_segment_[city]].rank, index_in_segment(city));
+    };
+
+    const auto ka = key(a);
+    const auto kb = key(b);
+    const auto kc = key(c);
+
+    if (ka <= kc) {
+        return ka <= kb && kb <= kc;
+    }
+    return kb >= ka || kb <= kc;
+}
+
+// Splits segment at index (0 < index < size): the cities from index on become a new segment
+// right after it in tour order.
+void TwoLevelTour::split(std::size_t id, std::size_t index) {
+    const std::size_t tail_id = order_.size();
+    if (tail_id == segments_.size()) {
+        segments_.emplace_back();
+    }
+
+    Segment& segment = segments_[id];
+    Segment& tail = segments_[tail_id];
+    const std::size_t length = segment.cities.size();
+    tail.reversed = segment.reversed;
+
+    if (!segment.reversed) {
+        tail.cities.assign(segment.cities.begin() + static_cast<std::ptrdiff_t>(index), segment.cities.end());
+        segment.cities.resize(index);
+    }
+    else {
+        // Reversed, the tail is stored first.
+        const auto cut = segment.cities.begin() + static_cast<std::ptrdiff_t>(length - index);
+        tail.cities.assign(segment.cities.begin(), cut);
+        segment.cities.erase(segment.cities.begin(), cut);
+
+        for (std::size_t slot = 0; slot < segment.cities.size(); ++slot) {
+            city_slot_[segment.cities[slot]] = static_cast<std::uint32_t>(slot);
+        }
+    }
+
+    for (std::size_t slot = 0; slot < tail.cities.size(); ++slot) {
+        city_segment_[tail.cities[slot]] = static_cast<std::uint32_t>(tail_id);
+        city_slot_[tail.cities[slot]] = static_cast<std::uint32_t>(slot);
+    }
+
+    order_.insert(order_.begin() + static_cast<std::ptrdiff_t>(segment.rank + 1), tail_id);
+    for (std::size_t rank = segment.rank + 1; rank < order_.size(); ++rank) {
+        segments_[order_[rank]].rank = rank;
+    }
+}
+
+void TwoLevelTour::reverse(std::size_t from, std::size_t to) {
+    if (from == to) {
+        return;
+    }
+
+    if (const std::size_t index = index_in_segment(from); index > 0) {
+        split(city_segment_[from], index);
+    }
+    if (const std::size_t index = index_in_segment(to); index + 1 < segments_[city_segment_[to]].cities.size()) {
+        split(city_segment_[to], index + 1);
+    }
+
+    const std::size_t k = order_.size();
+    std::size_t first = segments_[city_segment_[from]].rank;
+    std::size_t last = segments_[city_segment_[to]].rank;
+    std::size_t count = (last + k - first) % k + 1;
+
+    // Reversing every segment leaves the cycle as it is.
+    if (count < k) {
+        if (count > k - count) {
+            first = (last + 1) % k;
+            last = (first + k - count - 1) % k;
+            count = k - count;
+        }
+
+        for (std::size_t i = 0; i < count / 2; ++i) {
+            std::swap(order_[(first + i) % k], order_[(last + k - i) % k]);
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            Segment& segment = segments_[order_[(first + i) % k]];
+            segment.reversed = !segment.reversed;
+            segment.rank = (first + i) % k;
+        }
+    }
+
+    // Splits add up to two segments per reversal; regroup before lookups slow down.
+    if (order_.size() > 2 * (size() + segment_length_ - 1) / segment_length_) {
+        write(cities_);
+        rebuild();
+    }
+}
+
+void TwoLevelTour::flip(std::size_t a, std::size_t b, std::size_t d) {
+    if (next(a) == b) {
+        reverse(b, d);
+    } else {
+        reverse(d, b);
+    }
+}
+
+void TwoLevelTour::move_segment(std::size_t first, std::size_t last, std::size_t after, bool reversed) {
+    const std::size_t before = prev(first);
+    const std::size_t following = next(last);
+
+    // before first..last following .. after, then: before after .. following last..first,
+    // then: before following .. after last..first.
+    flip(before, first, after);
+    flip(before, after, following);
+    if (!reversed) {
+        flip(after, last, first);
+    }
+}
+
+Tour TwoLevelTour::to_tour() const {
+    Tour tour;
+    write(tour);
+
+    return tour;
+}
+
+void TwoLevelTour::write(Tour& tour) const {
+    tour.resize(size());
+
+    std::size_t position = 0;
+    for (const std::size_t id: order_) {
+        const Segment& segment = segments_[id];
+        for (std::size_t index = 0; index < segment.cities.size(); ++index) {
+            tour[position++] = city_at(segment, index);
+        }
+    }
+}
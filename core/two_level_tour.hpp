@@ -0,0 +1,67 @@
+#ifndef TSP_CORE_TWO_LEVEL_TOUR
+#define TSP_CORE_TWO_LEVEL_TOUR
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "tsp.hpp"
+
+// Tour kept as a cyclic list of about sqrt(n) segments, each a city array with a reversal bit.
+// next, prev and between are O(1). reverse splits at most two segments, then reverses the order
+// and the bits of the whole segments in between, so a 2-opt move costs O(sqrt(n)) instead of
+// the up to n/2 city swaps of an array reversal.
+class TwoLevelTour {
+public:
+    TwoLevelTour() = default;
+    explicit TwoLevelTour(const Tour& tour);
+
+    // Replaces the tour, reusing the storage of the previous one.
+    void assign(const Tour& tour);
+
+    std::size_t size() const { return city_segment_.size(); }
+
+    std::size_t next(std::size_t city) const;
+    std::size_t prev(std::size_t city) const;
+    // True when b lies on the forward path from a to c, ends included.
+    bool between(std::size_t a, std::size_t b, std::size_t c) const;
+
+    // Reverses the forward path from..to. It may reverse the rest of the tour instead, which
+    // gives the same cycle read in the other direction.
+    void reverse(std::size_t from, std::size_t to);
+    // Moves the short forward path first..last between after and next(after), as last..first when
+    // reversed; after must lie outside the path.
+    void move_segment(std::size_t first, std::size_t last, std::size_t after, bool reversed);
+
+    // The cities in forward order.
+    Tour to_tour() const;
+    void write(Tour& tour) const;
+
+private:
+    struct Segment {
+        std::vector<std::uint32_t> cities;
+        bool reversed = false;
+        std::size_t rank = 0;
+    };
+
+    std::size_t index_in_segment(std::size_t city) const;
+    std::uint32_t city_at(const Segment& segment, std::size_t index) const;
+    void split(std::size_t segment, std::size_t index);
+    void rebuild();
+
+    // 2-opt move on a tour reading a b ... d in either direction: reverses b..d.
+    void flip(std::size_t a, std::size_t b, std::size_t d);
+
+    // Segments in use have ids 0 .. order_.size() - 1; later ones only keep their storage.
+    std::vector<Segment> segments_;
+    // Segment ids in tour order; segments_[order_[r]].rank == r.
+    std::vector<std::size_t> order_;
+    // The tour being regrouped by rebuild.
+    Tour cities_;
+    std::vector<std::uint32_t> city_segment_;
+    // Position in the segment's array, before applying its reversal bit.
+    std::vector<std::uint32_t> city_slot_;
+    std::size_t segment_length_ = 1;
+};
+
+#endif
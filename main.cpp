@@ -17,15 +17,17 @@ const char* USAGE =
     "Usage:\n"
     "  tsp_optimizer --benchmark-mode timed --set small|medium|large|huge --time-limit 10s\n"
     "                [--algorithm sa|ga|aco|all] [--params default|custom]\n"
-    "                [--config FILE] [--two-opt true|false]\n"
-    "                [--label NAME] [--seed N] [--repeats N]\n"
+    "                [--config FILE] [--two-opt true|false] [--candidates nearest|quadrant|alpha|delaunay]\n"
+    "                [--local-search two_opt|or_opt|lin_kernighan]\n"
+    "                [--label NAME] [--seed N] [--repeats N] [--jobs N] [--pin-threads true|false]\n"
     "  tsp_optimizer --benchmark-mode stable --set small|medium|large|huge\n"
     "                [--algorithm sa|ga|aco|all] [--params default|custom]\n"
-    "                [--config FILE] [--two-opt true|false]\n"
+    "                [--config FILE] [--two-opt true|false] [--candidates nearest|quadrant|alpha|delaunay]\n"
+    "                [--local-search two_opt|or_opt|lin_kernighan]\n"
     "                [--min-iters 50] [--window 25] [--epsilon 0.0001]\n"
     "                [--plateau-time 60s] [--max-iters N]\n"
     "                (for SA, iters mean completed annealing restarts)\n"
-    "                [--label NAME] [--seed N] [--repeats N]\n"
+    "                [--label NAME] [--seed N] [--repeats N] [--jobs N] [--pin-threads true|false]\n"
     "\n"
     "Examples:\n"
     "  tsp_optimizer --benchmark-mode timed --set medium --time-limit 10s "
@@ -166,11 +168,12 @@ void run_bench(const Args& args) {
     config.benchmark_mode = require(args, "benchmark-mode");
     if (config.benchmark_mode == "timed") {
         reject_unknown_args(args, {"benchmark-mode", "set", "time-limit", "algorithm", "params",
-                                   "config", "two-opt", "label", "seed", "repeats"});
+                                   "config", "two-opt", "candidates", "local-search", "label", "seed", "repeats",
+                                   "jobs", "pin-threads"});
     } else if (config.benchmark_mode == "stable") {
         reject_unknown_args(args, {"benchmark-mode", "set", "algorithm", "params", "config", "two-opt",
-                                   "label", "seed", "repeats", "min-iters", "window", "epsilon",
-                                   "plateau-time", "max-iters"});
+                                   "candidates", "local-search", "label", "seed", "repeats", "jobs", "pin-threads",
+                                   "min-iters", "window", "epsilon", "plateau-time", "max-iters"});
     } else {
         throw std::invalid_argument("--benchmark-mode must be timed or stable");
     }
@@ -185,6 +188,12 @@ void run_bench(const Args& args) {
     if (has(args, "two-opt")) {
         config.two_opt_override = parse_bool_option(require(args, "two-opt"), "--two-opt");
     }
+    if (has(args, "candidates")) {
+        config.candidates_override = parse_candidate_kind(require(args, "candidates"));
+    }
+    if (has(args, "local-search")) {
+        config.local_search_override = parse_local_search(require(args, "local-search"));
+    }
     if (config.params == "custom") {
         config.custom_config = require(args, "config");
     } else if (has(args, "config")) {
@@ -192,6 +201,10 @@ void run_bench(const Args& args) {
     }
     config.seed = parse_seed(get(args, "seed", "42"));
     config.repeats = parse_int(get(args, "repeats", config.group == "huge" ? "1" : "3"), "repeats");
+    config.jobs = parse_int(get(args, "jobs", "1"), "jobs");
+    if (has(args, "pin-threads")) {
+        config.pin_threads = parse_bool_option(require(args, "pin-threads"), "--pin-threads");
+    }
 
     if (config.benchmark_mode == "timed") {
         config.time_limit = parse_seconds(require(args, "time-limit"), "--time-limit");
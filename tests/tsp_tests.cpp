@@ -1,21 +1,35 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "../algorithms/aco.hpp"
 #include "../algorithms/genetic.hpp"
 #include "../algorithms/sa.hpp"
+#include "../core/candidates.hpp"
 #include "../core/config.hpp"
+#include "../core/distance_kernels.hpp"
+#include "../core/instance_cache.hpp"
+#include "../core/kd_tree.hpp"
+#include "../core/local_search.hpp"
+#include "../core/prepared_instance.hpp"
 #include "../core/tsp.hpp"
+#include "../core/two_level_tour.hpp"
 
 namespace {
 
@@ -36,7 +50,7 @@ bool rejects_invalid_argument(const std::function<void()>& action) {
     return false;
 }
 
-void run_full_two_opt(std::vector<City>& path, const std::vector<double>& distance_matrix) {
+void run_full_two_opt(std::vector<City>& path, const DistanceMatrix<std::int32_t>& distance_matrix) {
     if (path.size() < 4) {
         return;
     }
@@ -194,6 +208,44 @@ void test_tsplib_parser_requires_exact_section_tokens() {
     expect(parser_rejected, "parser should require an exact NODE_COORD_SECTION token");
 }
 
+void test_tsplib_parser_handles_crlf_and_unterminated_lines() {
+    const auto path = temp_file("tsp_parser_crlf.tsp");
+
+    write_text_file(path,
+                    "NAME: parser_crlf\r\n"
+                    "DIMENSION: 3\r\n"
+                    "EDGE_WEIGHT_TYPE: EUC_2D\r\n"
+                    "NODE_COORD_SECTION\r\n"
+                    "2\t+3.0 0\r\n"
+                    "  1 0 0e0\r\n"
+                    "3 3 4");
+
+    std::vector<City> cities;
+    readfile(cities, path.string());
+
+    write_text_file(path,
+                    "DIMENSION: 2\n"
+                    "EDGE_WEIGHT_TYPE: EUC_2D\n"
+                    "NODE_COORD_SECTION\n"
+                    "1 0 0x\n"
+                    "2 1 1\n");
+
+    bool parser_rejected = false;
+    try {
+        std::vector<City> rejected;
+        readfile(rejected, path.string());
+    }
+    catch (const std::runtime_error&) {
+        parser_rejected = true;
+    }
+    std::filesystem::remove(path);
+
+    expect(cities.size() == 3 && cities[0].id == 1 && cities[1].point.first == 3.0,
+           "parser should accept CRLF line ends, tabs, signs and a missing final newline");
+    expect(total_cost(cities) == 12.0, "parser output should keep the coordinates of every city");
+    expect(parser_rejected, "parser should reject numbers with trailing garbage");
+}
+
 void test_distance_and_total_cost() {
     const auto cities = rectangle_tour();
 
@@ -207,6 +259,31 @@ void test_distance_and_total_cost() {
     expect(total_cost(shuffled, distance_matrix) == total_cost(shuffled), "matrix total cost should be indexed by city id, not vector position");
 }
 
+void test_distance_storage_selection() {
+    const auto cities = sample_cities();
+    const auto wide = build_distance_matrix(cities);
+
+    const bool compact = visit_distances(cities, [&](const auto& distances) {
+        using Value = typename std::decay_t<decltype(distances)>::value_type;
+
+        expect(total_cost(cities, distances) == total_cost(cities, wide), "compact matrix tour cost should be exact");
+        return std::is_same_v<Value, std::uint16_t>;
+    });
+    expect(compact, "small coordinates should select 16-bit distance storage");
+
+    std::vector<City> spread = rectangle_tour();
+    spread[2].point = {70000.0, 4.0};
+    const bool wide_selected = visit_distances(spread, [&](const auto& distances) {
+        using Value = typename std::decay_t<decltype(distances)>::value_type;
+
+        expect(total_cost(spread, distances) == total_cost(spread), "32-bit matrix tour cost should be exact");
+        return std::is_same_v<Value, std::int32_t>;
+    });
+    expect(wide_selected, "distances beyond 65535 should select 32-bit distance storage");
+    expect(rejects_invalid_argument([&]() { build_distance_matrix_as<std::uint16_t>(spread); }),
+           "16-bit distance storage should reject coordinates that do not fit");
+}
+
 void test_matrix_cost_rejects_invalid_ids() {
     const auto cities = rectangle_tour();
     const auto distance_matrix = build_distance_matrix(cities);
@@ -260,28 +337,31 @@ void test_sa_full_reversal_delta() {
     const auto cities = rectangle_tour();
     const auto distance_matrix = build_distance_matrix(cities);
 
-    expect(tour_reversal_delta(cities, distance_matrix, 0, cities.size() - 1) == 0.0, "reversing the full cycle should not change tour cost");
+    expect(tour_reversal_delta(to_tour(cities), distance_matrix, 0, cities.size() - 1) == 0.0, "reversing the full cycle should not change tour cost");
 }
 
 void test_genetic_crossover_validity() {
-    const auto parent1 = sample_cities();
-    auto parent2 = parent1;
+    const auto cities = sample_cities();
+    const auto city_by_index = cities_by_index(cities);
+    const Tour parent1 = to_tour(cities);
+    Tour parent2 = parent1;
     std::reverse(parent2.begin(), parent2.end());
 
-    set_random_seed(7);
+    SolverContext context(7);
     for (int i = 0; i < 50; ++i) {
-        const auto child = genetic_order_crossover(parent1, parent2);
-        expect(is_valid_tour(child), "GA crossover should produce a valid permutation");
+        const Tour child = genetic_order_crossover(parent1, parent2, context);
+        expect(is_valid_tour(to_cities(child, city_by_index)), "GA crossover should produce a valid permutation");
     }
 }
 
 void test_genetic_mutation_validity() {
-    auto tour = sample_cities();
+    const auto city_by_index = cities_by_index(sample_cities());
+    Tour tour = to_tour(sample_cities());
 
-    set_random_seed(11);
+    SolverContext context(11);
     for (int i = 0; i < 100; ++i) {
-        mutate_tour(tour);
-        expect(is_valid_tour(tour), "GA mutation should preserve a valid permutation");
+        mutate_tour(tour, context);
+        expect(is_valid_tour(to_cities(tour, city_by_index)), "GA mutation should preserve a valid permutation");
     }
 }
 
@@ -289,8 +369,8 @@ void test_genetic_does_not_worsen_starting_tour() {
     auto tour = sample_cities();
     const double starting_cost = total_cost(tour);
 
-    set_random_seed(19);
-    ga_solve(tour, GaParams{9, 0.35, false}, iteration_limit(1));
+    SolverContext context(19);
+    ga_solve(tour, GaParams{9, 0.35, false}, iteration_limit(1), context);
 
     expect(is_valid_tour(tour), "genetic algorithm should return a valid tour after one generation");
     expect(total_cost(tour) <= starting_cost, "genetic algorithm should not return a tour worse than the starting tour");
@@ -304,8 +384,8 @@ void test_aco_handles_zero_cost_tours() {
         {4, {0.0, 0.0}}
     };
 
-    set_random_seed(404);
-    aco_solve(cities, AcoParams{4, 1.0, 2.0, 0.2, false}, iteration_limit(5));
+    SolverContext context(404);
+    aco_solve(cities, AcoParams{4, 1.0, 2.0, 0.2, false}, iteration_limit(5), context);
 
     expect(is_valid_tour(cities), "ACO should preserve tour validity when all distances are zero");
     expect(std::isfinite(total_cost(cities)), "ACO should return a finite cost when all distances are zero");
@@ -315,21 +395,21 @@ void test_algorithms_preserve_valid_tours() {
     const auto base = sample_cities();
 
     auto sa_tour = base;
-    set_random_seed(101);
-    sa_solve(sa_tour, SaParams{100.0, 0.01, 0.95, true}, iteration_limit(2));
+    SolverContext sa_context(101);
+    sa_solve(sa_tour, SaParams{100.0, 0.01, 0.95, true}, iteration_limit(2), sa_context);
     expect(is_valid_tour(sa_tour), "simulated annealing should preserve tour validity");
     expect(std::isfinite(total_cost(sa_tour)), "simulated annealing should return a finite tour cost");
 
     auto ga_tour = base;
-    set_random_seed(202);
-    ga_solve(ga_tour, GaParams{9, 0.35, false}, iteration_limit(25));
+    SolverContext ga_context(202);
+    ga_solve(ga_tour, GaParams{9, 0.35, false}, iteration_limit(25), ga_context);
     expect(is_valid_tour(ga_tour), "genetic algorithm should preserve tour validity for odd population sizes");
     expect(std::isfinite(total_cost(ga_tour)), "genetic algorithm should return a finite tour cost");
 
     auto aco_tour = base;
     std::rotate(aco_tour.begin(), aco_tour.begin() + 3, aco_tour.end());
-    set_random_seed(303);
-    aco_solve(aco_tour, AcoParams{1, 1.0, 2.0, 0.2, false}, iteration_limit(8));
+    SolverContext aco_context(303);
+    aco_solve(aco_tour, AcoParams{1, 1.0, 2.0, 0.2, false}, iteration_limit(8), aco_context);
     expect(is_valid_tour(aco_tour), "ACO should preserve tour validity for unsorted input and one ant");
     expect(std::isfinite(total_cost(aco_tour)), "ACO should return a finite tour cost");
 }
@@ -364,7 +444,7 @@ std::vector<City> random_instance(std::size_t n, std::uint32_t seed) {
 }
 
 
-bool has_improving_two_opt(const std::vector<City>& path, const std::vector<double>& dist) {
+bool has_improving_two_opt(const std::vector<City>& path, const DistanceMatrix<std::int32_t>& dist) {
     const std::size_t n = path.size();
 
     for (std::size_t i = 0; i < n; ++i) {
@@ -378,10 +458,10 @@ bool has_improving_two_opt(const std::vector<City>& path, const std::vector<doub
 
             const std::size_t c = static_cast<std::size_t>(path[j].id - 1);
             const std::size_t d = static_cast<std::size_t>(path[(j + 1) % n].id - 1);
-            const double before = dist[a * n + b] + dist[c * n + d];
-            const double after = dist[a * n + c] + dist[b * n + d];
+            const std::int64_t before = std::int64_t{dist(a, b)} + dist(c, d);
+            const std::int64_t after = std::int64_t{dist(a, c)} + dist(b, d);
 
-            if (after + 1e-7 < before) {
+            if (after < before) {
                 return true;
             }
         }
@@ -390,13 +470,374 @@ bool has_improving_two_opt(const std::vector<City>& path, const std::vector<doub
     return false;
 }
 
+void test_coordinate_distance_matches_matrix() {
+    const auto cities = random_instance(45, 17);
+    const auto matrix = build_distance_matrix(cities);
+    const auto coordinates = build_coordinate_distance(cities);
+
+    for (std::size_t i = 0; i < cities.size(); ++i) {
+        for (std::size_t j = 0; j < cities.size(); ++j) {
+            expect(coordinates(i, j) == matrix(i, j), "coordinate distance should match the matrix entry");
+        }
+    }
+
+    const auto matrix_lists = build_neighbor_lists(matrix, cities.size(), 6);
+    const auto coordinate_lists = build_neighbor_lists(coordinates, cities.size(), 6);
+    for (std::size_t city = 0; city < cities.size(); ++city) {
+        for (std::size_t slot = 0; slot < 6; ++slot) {
+            expect(matrix_lists[city][slot].city == coordinate_lists[city][slot].city &&
+                   matrix_lists[city][slot].distance == coordinate_lists[city][slot].distance,
+                   "coordinate neighbor lists should match matrix neighbor lists");
+        }
+    }
+
+    auto tour = cities;
+    std::mt19937 rng(17);
+    std::shuffle(tour.begin(), tour.end(), rng);
+    const auto full_lists = build_neighbor_lists(coordinates, tour.size(), tour.size() - 1);
+    two_opt_neighbors(tour, coordinates, full_lists, std::numeric_limits<std::size_t>::max());
+    expect(!has_improving_two_opt(tour, matrix), "matrix-free 2-opt should reach a 2-opt local optimum");
+}
+
+void test_packed_distance_matrix_matches_dense() {
+    const auto cities = random_instance(37, 21);
+    const auto dense = build_distance_matrix(cities);
+    const auto packed = build_packed_distance_matrix_as<std::int32_t>(cities);
+
+    expect(packed.bytes() == 37 * 38 / 2 * sizeof(std::int32_t), "packed storage should hold one triangle");
+    for (std::size_t i = 0; i < cities.size(); ++i) {
+        for (std::size_t j = 0; j < cities.size(); ++j) {
+            expect(packed(i, j) == dense(i, j), "packed distance should match the dense matrix entry");
+            expect(TriangularMatrix<int>::index(i, j) == TriangularMatrix<int>::index(j, i),
+                   "packed index should be symmetric");
+        }
+    }
+
+    expect(choose_distance_storage(1000, 2, 0, std::size_t{1} << 20, DistanceStorage::Auto) ==
+           DistanceStorage::Packed, "a packed matrix within budget should be selected");
+    expect(choose_distance_storage(1000, 4, 16, std::size_t{1} << 20, DistanceStorage::Auto) ==
+           DistanceStorage::Coordinates, "storage beyond the budget should fall back to coordinates");
+    expect(choose_distance_storage(1000, 4, 16, 0, DistanceStorage::Dense) == DistanceStorage::Dense,
+           "an explicit storage request should be honored");
+}
+
+void test_kd_tree_neighbor_lists_match_scan() {
+    std::vector<City> grid;
+    for (int i = 0; i < 12; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            grid.push_back({static_cast<int>(grid.size() + 1), {10.0 * i, 10.0 * j}});
+        }
+    }
+
+    for (const auto& cities: {random_instance(300, 31), grid, sample_cities()}) {
+        const auto matrix = build_distance_matrix(cities);
+
+        for (const std::size_t k: {std::size_t{1}, std::size_t{7}, std::size_t{16}, cities.size()}) {
+            const auto scanned = build_neighbor_lists(matrix, cities.size(), k);
+            const auto spatial = build_neighbor_lists(cities, k);
+
+            expect(spatial.entries() == scanned.entries(), "k-d tree lists should have the scanned list sizes");
+            for (std::size_t city = 0; city < cities.size(); ++city) {
+                for (std::size_t slot = 0; slot < scanned[city].size(); ++slot) {
+                    expect(spatial[city][slot].city == scanned[city][slot].city &&
+                           spatial[city][slot].distance == scanned[city][slot].distance,
+                           "k-d tree neighbor lists should match the full scan, ties included");
+                }
+            }
+        }
+    }
+}
+
+void test_quadrant_neighbor_lists_cover_quadrants() {
+    std::vector<City> clustered = random_instance(60, 12);
+    for (auto& city: clustered) {
+        if (city.id > 30) {
+            city.point.first += 5000.0;
+        }
+    }
+
+    for (const auto& cities: {random_instance(200, 17), clustered}) {
+        const std::size_t k = 8;
+        const auto lists = build_quadrant_neighbor_lists(cities, k);
+
+        expect(lists.size() == cities.size() && lists.entries() == cities.size() * k,
+               "quadrant lists should hold k entries per city");
+        for (std::size_t city = 0; city < cities.size(); ++city) {
+            std::array<std::size_t, 4> available{};
+            std::array<std::size_t, 4> taken{};
+            for (std::size_t other = 0; other < cities.size(); ++other) {
+                if (other != city) {
+                    ++available[static_cast<std::size_t>(KdTree::quadrant_of(
+                        cities[other].point.first - cities[city].point.first, cities[other].point.second - cities[city].point.second))];
+                }
+            }
+            for (std::size_t slot = 0; slot < k; ++slot) {
+                const Neighbor& entry = lists[city][slot];
+                ++taken[static_cast<std::size_t>(KdTree::quadrant_of(
+                    cities[entry.city].point.first - cities[city].point.first, cities[entry.city].point.second - cities[city].point.second))];
+                expect(entry.city != city, "quadrant lists should not contain the city itself");
+                expect(slot == 0 || lists[city][slot - 1].distance <= entry.distance,
+                       "quadrant lists should be sorted by distance");
+            }
+            for (std::size_t quadrant = 0; quadrant < 4; ++quadrant) {
+                expect(taken[quadrant] >= std::min(available[quadrant], k / 4),
+                       "every populated quadrant should contribute k / 4 neighbors");
+            }
+        }
+    }
+
+    AcoParams params{4, 1.0, 2.0, 0.2, true};
+    params.candidates = CandidateKind::Quadrant;
+    auto tour = clustered;
+    SolverContext context(12);
+    const SolveResult result = aco_solve(tour, params, iteration_limit(3), context);
+    expect(is_valid_tour(tour), "ACO with quadrant candidates should return a valid tour");
+    expect(result.fallbacks > 0, "ACO should report full-scan fallbacks once candidate lists run dry");
+    expect(describe(params).find("candidates=quadrant") != std::string::npos,
+           "parameter description should include the candidate kind");
+}
+
+void test_alpha_neighbor_lists_keep_grid_edges() {
+    std::vector<City> grid;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            grid.push_back({static_cast<int>(grid.size() + 1), {10.0 * i, 10.0 * j}});
+        }
+    }
+
+    const std::size_t k = 5;
+    const auto lists = build_alpha_neighbor_lists(grid, k);
+
+    expect(lists.size() == grid.size() && lists.entries() == grid.size() * k,
+           "alpha lists should hold k entries per city");
+    for (std::size_t city = 0; city < grid.size(); ++city) {
+        std::size_t adjacent = 0;
+        for (std::size_t slot = 0; slot < k; ++slot) {
+            const Neighbor& entry = lists[city][slot];
+            expect(entry.city != city, "alpha lists should not contain the city itself");
+            expect(slot == 0 || lists[city][slot - 1].distance <= entry.distance,
+                   "alpha lists should be sorted by distance");
+            adjacent += entry.distance == 10 ? 1 : 0;
+        }
+
+        const std::size_t row = city / 8;
+        const std::size_t column = city % 8;
+        const std::size_t expected = (row > 0) + (row < 9) + (column > 0) + (column < 7);
+        expect(adjacent == expected, "alpha lists should keep every axis-adjacent grid neighbor");
+    }
+
+    auto tour = random_instance(120, 6);
+    const auto base = tour;
+    SaParams params{100.0, 0.01, 0.95, true};
+    params.candidates = CandidateKind::Alpha;
+    SolverContext context(6);
+    sa_solve(tour, params, iteration_limit(2), context);
+    expect(is_valid_tour(tour) && tour.size() == base.size(), "SA with alpha candidates should return a valid tour");
+}
+
+void test_vectorized_distances_match_scalar() {
+    const auto cities = random_instance(37, 23);
+    const CoordinateDistance coordinates = build_coordinate_distance(cities);
+
+    for (std::size_t count = 0; count <= cities.size(); ++count) {
+        std::vector<std::int32_t> row(count + 1, -1);
+        euc2d_distances(coordinates.x().data(), coordinates.y().data(), 3.25, 999.5, count, row.data());
+
+        for (std::size_t j = 0; j < count; ++j) {
+            expect(row[j] == tsplib_distance({0, {3.25, 999.5}}, {1, {coordinates.x()[j], coordinates.y()[j]}}),
+                   std::string("vectorized distances should match the scalar formula (") + euc2d_kernel_name() + ")");
+        }
+        expect(row[count] == -1, "vectorized distances should not write past count");
+    }
+
+    const auto dense = build_distance_matrix_as<std::uint16_t>(cities);
+    const auto packed = build_packed_distance_matrix_as<std::uint16_t>(cities);
+    for (std::size_t i = 0; i < cities.size(); ++i) {
+        for (std::size_t j = 0; j < cities.size(); ++j) {
+            expect(dense(i, j) == coordinates(i, j) && packed(i, j) == coordinates(i, j),
+                   "parallel matrix builders should match per-pair distances");
+        }
+    }
+}
+
+// Prim's algorithm over the given edges only; the full graph when neighbors is null.
+std::int64_t spanning_tree_weight(const DistanceMatrix<std::int32_t>& matrix, const NeighborLists* neighbors) {
+    const std::size_t n = matrix.size();
+    std::vector<std::int64_t> best(n, std::numeric_limits<std::int64_t>::max());
+    std::vector<char> inside(n, 0);
+    std::int64_t weight = 0;
+
+    best[0] = 0;
+    for (std::size_t step = 0; step < n; ++step) {
+        std::size_t next = n;
+        for (std::size_t city = 0; city < n; ++city) {
+            if (!inside[city] && (next == n || best[city] < best[next])) {
+                next = city;
+            }
+        }
+        expect(best[next] != std::numeric_limits<std::int64_t>::max(), "spanning graph should be connected");
+
+        inside[next] = 1;
+        weight += best[next];
+        if (neighbors == nullptr) {
+            for (std::size_t city = 0; city < n; ++city) {
+                best[city] = std::min<std::int64_t>(best[city], matrix(next, city));
+            }
+        }
+        else {
+            for (const Neighbor& neighbor: (*neighbors)[next]) {
+                best[neighbor.city] = std::min<std::int64_t>(best[neighbor.city], neighbor.distance);
+            }
+        }
+    }
+
+    return weight;
+}
+
+void test_delaunay_neighbor_lists_contain_mst() {
+    std::vector<City> grid;
+    for (int i = 0; i < 15; ++i) {
+        for (int j = 0; j < 11; ++j) {
+            grid.push_back({static_cast<int>(grid.size() + 1), {10.0 * i, 10.0 * j}});
+        }
+    }
+
+    std::vector<City> coincident = random_instance(150, 44);
+    for (std::size_t i = 0; i < 20; ++i) {
+        coincident.push_back({static_cast<int>(coincident.size() + 1), coincident[i * 3].point});
+    }
+
+    std::vector<City> line;
+    for (int i = 0; i < 30; ++i) {
+        line.push_back({i + 1, {5.0 * i, 0.0}});
+    }
+
+    expect(build_delaunay_neighbor_lists(grid, grid.size()).entries() <= 6 * grid.size(),
+           "Delaunay lists should hold O(n) edges");
+
+    for (const auto& cities: {random_instance(400, 41), grid, coincident, line}) {
+        const auto matrix = build_distance_matrix(cities);
+        const auto lists = build_delaunay_neighbor_lists(cities, cities.size());
+
+        expect(lists.size() == cities.size(), "Delaunay lists should cover every city");
+        for (std::size_t city = 0; city < cities.size(); ++city) {
+            for (std::size_t slot = 0; slot < lists[city].size(); ++slot) {
+                expect(lists[city][slot].distance == matrix(city, lists[city][slot].city),
+                       "Delaunay lists should cache exact distances");
+                expect(slot == 0 || lists[city][slot - 1].distance <= lists[city][slot].distance,
+                       "Delaunay lists should be sorted by distance");
+            }
+        }
+        expect(spanning_tree_weight(matrix, &lists) == spanning_tree_weight(matrix, nullptr),
+               "Delaunay edges should contain a minimum spanning tree");
+    }
+}
+
+bool same_neighbor_lists(const NeighborLists& a, const NeighborLists& b) {
+    if (a.size() != b.size() || a.entries() != b.entries()) {
+        return false;
+    }
+    for (std::size_t city = 0; city < a.size(); ++city) {
+        if (a[city].size() != b[city].size()) {
+            return false;
+        }
+        for (std::size_t slot = 0; slot < a[city].size(); ++slot) {
+            if (a[city][slot].city != b[city][slot].city || a[city][slot].distance != b[city][slot].distance) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void test_instance_cache_round_trip() {
+    const auto path = temp_file("tsp_instance_cache.tsp");
+    const auto cities = random_instance(120, 45);
+    std::ostringstream text;
+
+    text << "NAME: cache\nDIMENSION: " << cities.size() << "\nEDGE_WEIGHT_TYPE: EUC_2D\nNODE_COORD_SECTION\n";
+    text.precision(17);
+    for (const auto& city: cities) {
+        text << city.id << " " << city.point.first << " " << city.point.second << "\n";
+    }
+    write_text_file(path, text.str() + "EOF\n");
+    std::filesystem::remove(binary_instance_path(path.string()));
+
+    const auto nearest = build_candidate_lists(cities, CandidateKind::Nearest, 8);
+    const auto delaunay = build_candidate_lists(cities, CandidateKind::Delaunay, 8);
+    {
+        InstanceCache cold(path.string());
+        expect(!cold.warm(), "a missing .tspb should be generated from the .tsp");
+        expect(cold.cities() == cities, "a cold load should match the parser");
+        const PreparedInstance prepared(cold, InstanceRequirements{0, {{CandidateKind::Nearest, 8}}});
+        NeighborLists recorded;
+        expect(cold.find(CandidateKind::Nearest, 8, recorded) && same_neighbor_lists(recorded, nearest),
+               "lists built while preparing from a cache should be recorded in it");
+        expect(&prepared.candidates(CandidateKind::Nearest, 8)[0][0] == &recorded[0][0],
+               "a prepared instance should view the lists its cache holds");
+        cold.save();
+    }
+    {
+        InstanceCache warm(path.string());
+        NeighborLists cached;
+        expect(warm.warm() && warm.cities() == cities, "a matching .tspb should supply the cities");
+        expect(warm.find(CandidateKind::Nearest, 8, cached) && same_neighbor_lists(cached, nearest),
+               "cached lists should match freshly built ones");
+        expect(cached.viewed(), "mapped lists should be viewed in place, not copied");
+
+        NeighborLists copy = cached;
+        NeighborLists extended = cached;
+        extended.append(nullptr, nullptr);
+        expect(copy.viewed() && &copy[0][0] == &cached[0][0] && !extended.viewed() &&
+                   extended.size() == cached.size() + 1 && same_neighbor_lists(NeighborLists(std::move(copy)), nearest),
+               "copies of a view should share it until appended to");
+
+        expect(!warm.find(CandidateKind::Delaunay, 8, cached), "only lists that were built should be cached");
+        const PreparedInstance prepared(warm, InstanceRequirements{0, {{CandidateKind::Delaunay, 8}}});
+        expect(same_neighbor_lists(prepared.candidates(CandidateKind::Delaunay, 8), delaunay),
+               "lists missing from the cache should still be built");
+        warm.save();
+    }
+
+    write_text_file(path, text.str() + "\nEOF\n");
+    {
+        InstanceCache changed(path.string());
+        expect(!changed.warm(), "an edited .tsp should invalidate its .tspb");
+    }
+
+    std::filesystem::remove(binary_instance_path(path.string()));
+    std::filesystem::remove(path);
+}
+
+void test_distance_budget_selects_coordinates() {
+    setenv("TSP_DISTANCE_BUDGET_MB", "0", 1);
+
+    const auto base = random_instance(30, 8);
+    const bool matrix_free = visit_distances(base, [](const auto& distances) {
+        return std::is_same_v<std::decay_t<decltype(distances)>, CoordinateDistance>;
+    });
+
+    auto aco_tour = base;
+    SolverContext aco_context(8);
+    aco_solve(aco_tour, AcoParams{4, 1.0, 2.0, 0.2, true}, iteration_limit(5), aco_context);
+
+    auto ga_tour = base;
+    SolverContext ga_context(8);
+    ga_solve(ga_tour, GaParams{10, 0.2, true}, iteration_limit(5), ga_context);
+    unsetenv("TSP_DISTANCE_BUDGET_MB");
+
+    expect(matrix_free, "an exhausted distance budget should select the matrix-free provider");
+    expect(is_valid_tour(aco_tour), "matrix-free ACO should return a valid tour");
+    expect(is_valid_tour(ga_tour), "matrix-free GA should return a valid tour");
+}
+
 void test_neighbor_two_opt_reaches_local_optimum() {
     for (std::uint32_t seed = 1; seed <= 6; ++seed) {
         auto cities = random_instance(35, seed);
         const auto dist = build_distance_matrix(cities);
 
-        set_random_seed(seed);
-        std::shuffle(cities.begin(), cities.end(), gen);
+        SolverContext context(seed);
+        shuffle_range(cities.begin(), cities.end(), context.rng);
         const double start = total_cost(cities, dist);
 
         run_full_two_opt(cities, dist);
@@ -414,8 +855,8 @@ void test_bounded_neighbor_two_opt_is_safe() {
     const auto dist = build_distance_matrix(cities);
     const auto neighbors = build_neighbor_lists(dist, cities.size(), 8);
 
-    set_random_seed(123);
-    std::shuffle(cities.begin(), cities.end(), gen);
+    SolverContext context(123);
+    shuffle_range(cities.begin(), cities.end(), context.rng);
     const double start = total_cost(cities, dist);
 
     const std::size_t moves = two_opt_neighbors(cities, dist, neighbors, 5);
@@ -424,6 +865,24 @@ void test_bounded_neighbor_two_opt_is_safe() {
     expect(total_cost(cities, dist) <= start + 1e-9, "bounded neighbor 2-opt must never worsen the tour");
 }
 
+void test_index_tour_matches_city_tour() {
+    auto cities = random_instance(60, 77);
+    const auto dist = build_distance_matrix(cities);
+    const auto neighbors = build_neighbor_lists(dist, cities.size(), 8);
+
+    SolverContext context(77);
+    shuffle_range(cities.begin(), cities.end(), context.rng);
+    Tour tour = to_tour(cities);
+
+    expect(to_cities(tour, cities_by_index(cities)) == cities, "index tours should round-trip to the same city order");
+    expect(static_cast<double>(total_cost_unchecked(tour, dist)) == total_cost(cities, dist),
+           "index tours should cost the same as the city tour");
+
+    two_opt_neighbors_unchecked(tour, dist, neighbors, std::numeric_limits<std::size_t>::max());
+    two_opt_neighbors(cities, dist, neighbors, std::numeric_limits<std::size_t>::max());
+    expect(to_cities(tour, cities_by_index(cities)) == cities, "2-opt on index tours should match the city-tour wrapper");
+}
+
 void test_run_controller_detects_stability() {
     RunController controller(until_stable(/*min_iters=*/3, /*window=*/2, /*epsilon=*/0.001,
                                          /*plateau_seconds=*/0.0, 1000000));
@@ -498,9 +957,9 @@ void test_timed_mode_runs_and_stops() {
     auto cities = random_instance(60, 7);
     const double budget_seconds = 0.05;
 
-    set_random_seed(7);
+    SolverContext context(7);
     const auto t0 = std::chrono::steady_clock::now();
-    const SolveResult result = sa_solve(cities, SaParams{100.0, 0.1, 0.5}, time_limit(budget_seconds));
+    const SolveResult result = sa_solve(cities, SaParams{100.0, 0.1, 0.5}, time_limit(budget_seconds), context);
     const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
 
     expect(is_valid_tour(cities), "a timed run should return a valid tour");
@@ -516,8 +975,8 @@ void test_sa_berlin52_reaches_known_optimum() {
     std::vector<City> cities;
     readfile(cities, (project_root() / "tsplib" / "tests" / "berlin52.tsp").string());
 
-    set_random_seed(derive_run_seed(42, 0x005Au, 0, 0));
-    const SolveResult result = sa_solve(cities, SaParams{10000.0, 0.001, 0.99999, false}, iteration_limit(3));
+    SolverContext context(derive_run_seed(42, 0x005Au, 0, 0));
+    const SolveResult result = sa_solve(cities, SaParams{10000.0, 0.001, 0.99999, false}, iteration_limit(3), context);
 
     expect(result.cost == 7542.0, "SA berlin52 end-to-end run should reach the known optimum");
     expect(total_cost(cities) == 7542.0, "SA berlin52 returned tour should have zero gap");
@@ -527,10 +986,10 @@ void test_sa_berlin52_reaches_known_optimum() {
 void test_sa_stable_mode_uses_restart_stagnation() {
     auto cities = random_instance(30, 5);
 
-    set_random_seed(5);
+    SolverContext context(5);
     const SolveResult result = sa_solve(cities, SaParams{100.0, 0.1, 0.5},
                                         until_stable(/*min_iters=*/2, /*window=*/2, /*epsilon=*/1000.0,
-                                                     /*plateau_seconds=*/0.0, 1000000));
+                                                     /*plateau_seconds=*/0.0, 1000000), context);
 
     expect(result.converged, "SA stable mode should report stability");
     expect(result.stop_reason == StopReason::Stable, "SA stable mode should stop by restart-level stability");
@@ -548,6 +1007,608 @@ void test_derive_run_seed_is_deterministic_and_distinct() {
     expect(derive_run_seed(42, 0x005Au, 0, 1) != base, "a different repeat index must change the run seed");
 }
 
+
+void test_solver_contexts_are_independent() {
+    const auto base = random_instance(80, 64);
+    const GaParams params{12, 0.3, true};
+
+    std::vector<City> sequential = base;
+    SolverContext sequential_context(derive_run_seed(42, 0x006Au, 2, 1));
+    ga_solve(sequential, params, iteration_limit(20), sequential_context);
+
+    std::vector<std::vector<City>> tours(3, base);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < tours.size(); ++i) {
+        workers.emplace_back([&, i]() {
+            SolverContext context(derive_run_seed(42, 0x006Au, 2, i));
+            ga_solve(tours[i], params, iteration_limit(20), context);
+        });
+    }
+    for (auto& worker: workers) {
+        worker.join();
+    }
+
+    expect(tours[1] == sequential, "a run must not depend on other runs solving at the same time");
+    expect(tours[0] != tours[1], "different run seeds should explore different tours");
+
+    Rng rng(9);
+    bool bounded = true;
+    for (int i = 0; i < 1000; ++i) {
+        bounded = bounded && rng.below(7) < 7 && rng.uniform() < 1.0;
+    }
+    expect(bounded, "Rng helpers must stay inside their ranges");
+}
+void test_prepared_instance_matches_direct_solve() {
+    auto base = random_instance(70, 88);
+    const AcoParams aco_params{4, 1.0, 2.0, 0.2, true};
+    const GaParams ga_params{10, 0.3, true};
+
+    InstanceRequirements requirements = aco_requirements(aco_params);
+    requirements.merge(ga_requirements(ga_params));
+    requirements.merge(ga_requirements(ga_params));
+    expect(requirements.candidates.size() == 2, "merged requirements should hold each list size once");
+
+    std::reverse(base.begin(), base.end());
+    const PreparedInstance instance(base, requirements);
+    expect(instance.size() == base.size() && instance.cities().front().id == 1,
+           "prepared instances should keep the cities in id order");
+    expect(rejects_invalid_argument([&]() { instance.candidates(CandidateKind::Nearest, 7); }),
+           "unrequested candidate lists should be rejected");
+
+    std::vector<City> direct = instance.cities();
+    std::vector<City> shared = instance.cities();
+    SolverContext direct_context(5);
+    SolverContext shared_context(5);
+    ga_solve(direct, ga_params, iteration_limit(6), direct_context);
+    ga_solve(shared, instance, ga_params, iteration_limit(6), shared_context);
+    expect(direct == shared, "GA should find the same tour with or without a prepared instance");
+
+    direct = instance.cities();
+    shared = instance.cities();
+    direct_context = SolverContext(6);
+    shared_context = SolverContext(6);
+    aco_solve(direct, aco_params, iteration_limit(4), direct_context);
+    aco_solve(shared, instance, aco_params, iteration_limit(4), shared_context);
+    expect(direct == shared, "ACO should find the same tour with or without a prepared instance");
+
+    std::vector<City> foreign = random_instance(70, 89);
+    SolverContext foreign_context(7);
+    expect(rejects_invalid_argument([&]() {
+               ga_solve(foreign, instance, ga_params, iteration_limit(1), foreign_context);
+           }),
+           "solving a tour from another instance should be rejected");
+}
+void test_or_opt_moves_segments_back() {
+    std::vector<City> circle;
+    for (int i = 0; i < 24; ++i) {
+        const double angle = 2.0 * 3.14159265358979 * i / 24.0;
+        circle.push_back({i + 1, {1000.0 * std::cos(angle), 1000.0 * std::sin(angle)}});
+    }
+    const auto dist = build_distance_matrix(circle);
+    const auto neighbors = build_neighbor_lists(dist, circle.size(), 6);
+    const std::int64_t optimum = total_cost_unchecked(to_tour(circle), dist);
+
+    // City 5 and the reversed segment 12..14 moved across the circle.
+    Tour tour = {0, 1, 2, 3, 5, 6, 7, 8, 9, 10, 14, 15, 16, 17, 18, 19, 20, 4, 21, 13, 12, 11, 22, 23};
+    const std::size_t moves = or_opt_neighbors_unchecked(tour, dist, neighbors, 100);
+
+    expect(is_valid_tour(to_cities(tour, circle)), "Or-opt must preserve a valid permutation");
+    expect(moves >= 2 && total_cost_unchecked(tour, dist) == optimum,
+           "Or-opt should move the displaced city and segment back into place");
+
+    for (std::uint32_t seed = 1; seed <= 6; ++seed) {
+        auto cities = random_instance(60, seed);
+        const auto random_dist = build_distance_matrix(cities);
+        const auto full_lists = build_neighbor_lists(random_dist, cities.size(), cities.size() - 1);
+
+        SolverContext context(seed);
+        shuffle_range(cities.begin(), cities.end(), context.rng);
+        Tour random_tour = to_tour(cities);
+        const std::int64_t start = total_cost_unchecked(random_tour, random_dist);
+
+        two_opt_or_opt_neighbors_unchecked(random_tour, random_dist, full_lists, std::numeric_limits<std::size_t>::max());
+        const auto improved = to_cities(random_tour, cities_by_index(cities));
+
+        expect(is_valid_tour(improved), "2-opt + Or-opt must preserve a valid permutation");
+        expect(total_cost_unchecked(random_tour, random_dist) < start, "2-opt + Or-opt should improve a random tour");
+        expect(!has_improving_two_opt(improved, random_dist),
+               "2-opt + Or-opt with full lists must end at a 2-opt local optimum");
+    }
+}
+void test_lin_kernighan_beats_two_opt() {
+    std::int64_t two_opt_total = 0;
+    std::int64_t lin_kernighan_total = 0;
+
+    for (std::uint32_t seed = 1; seed <= 6; ++seed) {
+        auto cities = random_instance(80, seed);
+        const auto dist = build_distance_matrix(cities);
+        const auto full_lists = build_neighbor_lists(dist, cities.size(), cities.size() - 1);
+        const auto neighbors = build_neighbor_lists(dist, cities.size(), 10);
+
+        SolverContext context(seed);
+        shuffle_range(cities.begin(), cities.end(), context.rng);
+        const Tour start = to_tour(cities);
+
+        Tour two_opt_tour = start;
+        two_opt_neighbors_unchecked(two_opt_tour, dist, neighbors, std::numeric_limits<std::size_t>::max());
+        two_opt_total += total_cost_unchecked(two_opt_tour, dist);
+
+        Tour tour = start;
+        lin_kernighan_neighbors_unchecked(tour, dist, neighbors, std::numeric_limits<std::size_t>::max());
+        lin_kernighan_total += total_cost_unchecked(tour, dist);
+        expect(is_valid_tour(to_cities(tour, cities_by_index(cities))), "Lin-Kernighan must preserve a valid permutation");
+
+        tour = start;
+        lin_kernighan_neighbors_unchecked(tour, dist, full_lists, std::numeric_limits<std::size_t>::max());
+        expect(!has_improving_two_opt(to_cities(tour, cities_by_index(cities)), dist),
+               "Lin-Kernighan with full lists must end at a 2-opt local optimum");
+    }
+
+    expect(lin_kernighan_total < two_opt_total, "Lin-Kernighan should find shorter tours than 2-opt");
+}
+// Reference for TwoLevelTour: the same cycle kept in a plain array.
+void reverse_cycle(Tour& tour, std::uint32_t from, std::uint32_t to) {
+    const std::size_t n = tour.size();
+    const auto i = static_cast<std::size_t>(std::find(tour.begin(), tour.end(), from) - tour.begin());
+    const auto j = static_cast<std::size_t>(std::find(tour.begin(), tour.end(), to) - tour.begin());
+    const std::size_t len = (j + n - i) % n + 1;
+
+    for (std::size_t s = 0; s < len / 2; ++s) {
+        std::swap(tour[(i + s) % n], tour[(j + n - s) % n]);
+    }
+}
+
+bool same_cycle(const TwoLevelTour& tour, const Tour& reference) {
+    const std::size_t n = reference.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t next = reference[(i + 1) % n];
+        const std::size_t prev = reference[(i + n - 1) % n];
+        const bool forward = tour.next(reference[i]) == next && tour.prev(reference[i]) == prev;
+        const bool backward = tour.next(reference[i]) == prev && tour.prev(reference[i]) == next;
+        if (!forward && !backward) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void test_two_level_tour_matches_array() {
+    Tour reference(300);
+    for (std::uint32_t i = 0; i < reference.size(); ++i) {
+        reference[i] = i;
+    }
+    Rng rng(17);
+    shuffle_range(reference.begin(), reference.end(), rng);
+
+    TwoLevelTour tour(reference);
+    for (int step = 0; step < 2000; ++step) {
+        const auto from = static_cast<std::uint32_t>(rng.below(reference.size()));
+        const auto to = static_cast<std::uint32_t>(rng.below(reference.size()));
+
+        // Reverse the same cities in both; the two-level tour may read the cycle the other way.
+        const auto from_index = static_cast<std::size_t>(std::find(reference.begin(), reference.end(), from) -
+                                                         reference.begin());
+        if (tour.next(from) == reference[(from_index + 1) % reference.size()]) {
+            tour.reverse(from, to);
+        } else {
+            tour.reverse(to, from);
+        }
+        reverse_cycle(reference, from, to);
+
+        if (step % 100 == 0) {
+            expect(same_cycle(tour, reference), "two-level reversals should match array reversals");
+        }
+    }
+    expect(same_cycle(tour, reference), "two-level reversals should match array reversals");
+
+    const Tour order = tour.to_tour();
+    expect(order.size() == reference.size() && same_cycle(TwoLevelTour(order), reference),
+           "two-level tours should read back the same cycle");
+    for (std::size_t i = 0; i + 2 < order.size(); i += 37) {
+        expect(tour.between(order[i], order[i + 1], order[i + 2]) && !tour.between(order[i], order[i + 2], order[i + 1]),
+               "between should follow the forward direction");
+    }
+
+    // Or-opt moves: take 1 to 3 cities out and put them back elsewhere, in either orientation.
+    for (int step = 0; step < 200; ++step) {
+        const std::size_t first = rng.below(order.size());
+        std::size_t last = first;
+        for (std::size_t i = rng.below(3); i > 0; --i) {
+            last = tour.next(last);
+        }
+        std::size_t after = tour.next(tour.next(last));
+        for (std::size_t i = rng.below(50); i > 0; --i) {
+            after = tour.next(after);
+        }
+        if (tour.between(first, after, last)) {
+            continue;
+        }
+        const bool reversed = rng.below(2) == 1;
+        const std::size_t before = tour.prev(first);
+        const std::size_t following = tour.next(last);
+        const std::size_t successor = tour.next(after);
+
+        tour.move_segment(first, last, after, reversed);
+        const bool joined = tour.next(before) == following || tour.prev(before) == following;
+        const std::size_t near_after = reversed ? last : first;
+        const std::size_t near_successor = reversed ? first : last;
+        expect(joined && (tour.next(after) == near_after || tour.prev(after) == near_after) &&
+                   (tour.next(successor) == near_successor || tour.prev(successor) == near_successor),
+               "move_segment should reconnect the tour around the moved path");
+    }
+
+    const Tour moved = tour.to_tour();
+    std::vector<std::uint32_t> sorted(moved.begin(), moved.end());
+    std::sort(sorted.begin(), sorted.end());
+    expect(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end() && sorted.size() == reference.size(),
+           "two-level tours should stay permutations");
+
+    auto cities = random_instance(3000, 23);
+    const auto dist = build_distance_matrix(cities);
+    const auto neighbors = build_neighbor_lists(dist, cities.size(), 8);
+    SolverContext context(23);
+    shuffle_range(cities.begin(), cities.end(), context.rng);
+    Tour polished = to_tour(cities);
+    const std::int64_t start = total_cost_unchecked(polished, dist);
+
+    expect(choose_tour_store(cities.size(), TourStore::Auto) == TourStore::TwoLevel,
+           "large tours should use the two-level store");
+    lin_kernighan_neighbors_unchecked(polished, dist, neighbors, std::numeric_limits<std::size_t>::max());
+    expect(is_valid_tour(to_cities(polished, cities_by_index(cities))) && total_cost_unchecked(polished, dist) < start,
+           "local search on a two-level tour should return a valid, shorter tour");
+}
+void test_local_search_workspace_seeds() {
+    LocalSearchWorkspace workspace;
+    for (std::uint32_t seed = 1; seed <= 4; ++seed) {
+        auto cities = random_instance(150, seed);
+        const auto dist = build_distance_matrix(cities);
+        const auto neighbors = build_neighbor_lists(dist, cities.size(), 10);
+        SolverContext context(seed);
+        shuffle_range(cities.begin(), cities.end(), context.rng);
+
+        Tour fresh = to_tour(cities);
+        Tour reused = fresh;
+        lin_kernighan_neighbors_unchecked(fresh, dist, neighbors, std::numeric_limits<std::size_t>::max());
+        lin_kernighan_neighbors_unchecked(reused, dist, neighbors, std::numeric_limits<std::size_t>::max(), nullptr,
+                                          &workspace);
+        expect(fresh == reused, "a reused workspace should not change the search");
+
+        expect(two_opt_neighbors_unchecked(reused, dist, neighbors, std::numeric_limits<std::size_t>::max(), nullptr,
+                                           &workspace) == 0,
+               "a local optimum should admit no move");
+
+        // Reversing 40..89 rewires edges (39, 40) and (89, 90).
+        Tour perturbed = reused;
+        std::reverse(perturbed.begin() + 40, perturbed.begin() + 90);
+        const std::int64_t perturbed_cost = total_cost_unchecked(perturbed, dist);
+        auto seed_perturbation = [&]() {
+            for (const std::size_t i: {39, 40, 89, 90}) {
+                workspace.seed(perturbed[i]);
+            }
+        };
+
+        Tour polished = perturbed;
+        seed_perturbation();
+        const std::size_t moves = two_opt_neighbors_unchecked(polished, dist, neighbors,
+                                                              std::numeric_limits<std::size_t>::max(), nullptr,
+                                                              &workspace);
+        expect(workspace.seeds.empty(), "a search should consume the seeds");
+        expect(moves > 0 && total_cost_unchecked(polished, dist) < perturbed_cost &&
+                   is_valid_tour(to_cities(polished, cities_by_index(cities))),
+               "a seeded search should repair the perturbation");
+        expect(workspace.gain == perturbed_cost - total_cost_unchecked(polished, dist),
+               "a search should report the length its moves removed");
+
+        // The same search on a plain array with positions the caller keeps.
+        Tour in_place = perturbed;
+        std::vector<std::uint32_t> positions(in_place.size());
+        for (std::size_t i = 0; i < in_place.size(); ++i) {
+            positions[in_place[i]] = static_cast<std::uint32_t>(i);
+        }
+        seed_perturbation();
+        expect(array_local_search_unchecked(in_place.data(), positions.data(), in_place.size(), dist, neighbors,
+                                            LocalSearch::TwoOpt, std::numeric_limits<std::size_t>::max(), nullptr,
+                                            workspace) == moves &&
+                   in_place == polished,
+               "an in-place search should match the search on a Tour");
+        bool positions_kept = true;
+        for (std::size_t i = 0; i < in_place.size(); ++i) {
+            positions_kept = positions_kept && positions[in_place[i]] == i;
+        }
+        expect(positions_kept, "an in-place search should keep the positions in step with the tour");
+
+        seed_perturbation();
+        two_opt_neighbors_unchecked(perturbed, dist, neighbors, 1, nullptr, &workspace);
+        expect(std::count(workspace.queued.begin(), workspace.queued.end(), 0) ==
+                   static_cast<std::ptrdiff_t>(workspace.queued.size()),
+               "a search stopped by its move budget should unqueue the cities it left");
+
+        workspace.seed(0);
+        expect(two_opt_neighbors_unchecked(reused, dist, neighbors, 0, nullptr, &workspace) == 0 &&
+                   workspace.seeds.empty(),
+               "a search with no move budget should still clear the seeds");
+    }
+}
+void test_sa_neighbor_moves() {
+    expect(sa_params_from({{"start_temp", "100"}, {"end_temp", "0.1"}, {"cooling", "0.5"}, {"two_opt", "false"}}).moves ==
+               SaMoves::Neighbor,
+           "SA should default to neighbor moves");
+    expect(parse_sa_moves("segment") == SaMoves::Segment && sa_moves_text(SaMoves::Segment) == "segment",
+           "SA moves should round-trip through text");
+    bool rejected = false;
+    try {
+        parse_sa_moves("random");
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    expect(rejected, "unknown SA moves should be rejected");
+
+    const auto cities = random_instance(300, 19);
+    auto segment_tour = cities;
+    auto neighbor_tour = cities;
+    SaParams params{1000.0, 0.1, 0.9995, false};
+
+    params.moves = SaMoves::Segment;
+    SolverContext segment_context(19);
+    const SolveResult segment = sa_solve(segment_tour, params, iteration_limit(1), segment_context);
+    params.moves = SaMoves::Neighbor;
+    SolverContext neighbor_context(19);
+    const SolveResult neighbor = sa_solve(neighbor_tour, params, iteration_limit(1), neighbor_context);
+
+    expect(is_valid_tour(neighbor_tour) && neighbor.cost == total_cost(neighbor_tour),
+           "SA neighbor moves should keep a valid tour and track its cost");
+    expect(neighbor.cost < segment.cost, "SA neighbor moves should beat random segment reversals at equal steps");
+
+    // Above the two-level threshold the chain runs on a two-level list.
+    auto large_tour = random_instance(TWO_LEVEL_TOUR_MIN_CITIES + 100, 20);
+    SolverContext large_context(20);
+    const SolveResult large = sa_solve(large_tour, SaParams{100.0, 1.0, 0.9995, false}, iteration_limit(1),
+                                       large_context);
+    expect(is_valid_tour(large_tour) && large.cost == total_cost(large_tour),
+           "SA neighbor moves on a two-level tour should keep a valid tour and track its cost");
+}
+void test_sa_copies_best_tour_lazily() {
+    for (const SaMoves moves: {SaMoves::Segment, SaMoves::Neighbor}) {
+        auto cities = random_instance(200, 29);
+        SaParams params{1000.0, 0.1, 0.999, false};
+        params.moves = moves;
+        SolverContext context(29);
+        const SolveResult result = sa_solve(cities, params, iteration_limit(2), context);
+
+        expect(is_valid_tour(cities) && result.cost == total_cost(cities), "SA should return the best tour it tracked");
+        expect(result.saved_copy_cities > 0 && result.saved_copy_cities % cities.size() == 0,
+               "SA should skip whole-tour copies while a descent keeps finding new bests");
+    }
+}
+
+void test_sa_adaptive_schedule() {
+    const ConfigMap values = {
+        {"start_temp", "100"},
+        {"end_temp", "0.1"},
+        {"cooling", "0.5"},
+        {"two_opt", "false"},
+        {"schedule", "adaptive"},
+        {"reheats", "2"}
+    };
+    const SaParams params = sa_params_from(values);
+    expect(params.schedule == SaSchedule::Adaptive && params.reheats == 2, "SA config should read schedule and reheats");
+    expect(describe(params).find("schedule=adaptive;reheats=2") != std::string::npos,
+           "SA parameter description should include the schedule");
+
+    bool rejected = false;
+    try {
+        parse_sa_schedule("linear");
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    expect(rejected, "SA config should reject unknown schedules");
+
+    // A virtual clock that advances with every time check makes the pacing independent of the
+    // machine: the same run then plans, cools and stops identically every time.
+    for (const SaMoves moves: {SaMoves::Segment, SaMoves::Neighbor}) {
+        SaParams timed = params;
+        timed.moves = moves;
+        std::vector<SolveResult> results;
+
+        for (int run = 0; run < 2; ++run) {
+            auto cities = random_instance(200, 31);
+            std::atomic<std::uint64_t> checks{0};
+            StopCondition stop = time_limit(0.3);
+            stop.clock = [&checks] { return 1e-5 * static_cast<double>(++checks); };
+            SolverContext context(31);
+            results.push_back(sa_solve(cities, timed, stop, context));
+
+            expect(is_valid_tour(cities) && results.back().cost == total_cost(cities),
+                   "adaptive SA should return a valid tour");
+        }
+
+        expect(results[0].restarts >= 3 && results[0].stop_reason == StopReason::TimeLimit,
+               "adaptive SA should finish its first chain and both reheats before the time limit");
+        expect(results[0].cost == results[1].cost && results[0].restarts == results[1].restarts,
+               "adaptive SA paced by a virtual clock should not depend on wall time");
+    }
+}
+
+void test_sa_parallel_tempering() {
+    for (const SaMoves moves: {SaMoves::Segment, SaMoves::Neighbor}) {
+        SaParams params{1000.0, 0.1, 0.9999, false};
+        params.moves = moves;
+        params.replicas = 3;
+        std::vector<double> costs;
+
+        for (int run = 0; run < 2; ++run) {
+            auto cities = random_instance(200, 37);
+            SolverContext context(37);
+            const SolveResult result = sa_solve(cities, params, iteration_limit(2), context);
+
+            expect(is_valid_tour(cities) && result.cost == total_cost(cities),
+                   "parallel tempering should return the best tour of its replicas");
+            costs.push_back(result.cost);
+        }
+        expect(costs[0] == costs[1], "parallel tempering under a fixed schedule should not depend on thread timing");
+    }
+
+    const ConfigMap values = {
+        {"start_temp", "100"},
+        {"end_temp", "0.1"},
+        {"cooling", "0.5"},
+        {"two_opt", "false"},
+        {"replicas", "4"}
+    };
+    expect(sa_params_from(values).replicas == 4, "SA config should read replicas");
+}
+
+template <typename T>
+void check_batched_reversals(const std::vector<City>& cities) {
+    const auto distances = build_distance_matrix_as<T>(cities);
+    const auto packed = build_packed_distance_matrix_as<T>(cities);
+    const std::size_t n = cities.size();
+    std::mt19937 pick(41);
+    std::uniform_int_distribution<std::uint32_t> city(0, static_cast<std::uint32_t>(n - 1));
+
+    for (int batch = 0; batch < 100; ++batch) {
+        std::uint32_t a[DELTA_LANES], b[DELTA_LANES], c[DELTA_LANES], d[DELTA_LANES];
+        std::int64_t deltas[DELTA_LANES];
+        // The kernels never read the diagonal, so neither does the test.
+        for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+            do {
+                a[k] = city(pick);
+                b[k] = city(pick);
+                c[k] = city(pick);
+                d[k] = city(pick);
+            } while (a[k] == b[k] || a[k] == c[k] || b[k] == d[k] || c[k] == d[k]);
+        }
+        // The last off-diagonal entries, where a 4-byte uint16 gather ends at the packed array's end.
+        if (batch == 0) {
+            const auto last = static_cast<std::uint32_t>(n - 1);
+            a[0] = last;
+            b[0] = last - 2;
+            c[0] = last - 1;
+            d[0] = last;
+        }
+        std::int64_t packed_deltas[DELTA_LANES];
+        reversal_deltas(distances.row(0), n, a, b, c, d, deltas);
+        packed_reversal_deltas(packed.column(0), n, a, b, c, d, packed_deltas);
+        for (std::size_t k = 0; k < DELTA_LANES; ++k) {
+            const std::int64_t expected = std::int64_t{distances(a[k], c[k])} + distances(b[k], d[k]) -
+                                          distances(a[k], b[k]) - distances(c[k], d[k]);
+            expect(deltas[k] == expected, "gathered reversal deltas should match the matrix");
+            expect(packed_deltas[k] == expected, "gathered packed reversal deltas should match the matrix");
+        }
+    }
+
+    Tour tour = to_tour(cities);
+    const std::int64_t before = total_cost_unchecked(tour, distances);
+    Rng rng(41);
+    const std::int64_t change = sa_reversal_steps(tour, distances, 50.0, 20000, true, rng);
+    Tour sorted = tour;
+    std::sort(sorted.begin(), sorted.end());
+    expect(sorted == to_tour(cities) && total_cost_unchecked(tour, distances) == before + change,
+           "batched SA steps should report the change in tour length");
+
+    Tour packed_tour = to_tour(cities);
+    Rng packed_rng(41);
+    expect(sa_reversal_steps(packed_tour, packed, 50.0, 20000, true, packed_rng) == change && packed_tour == tour,
+           "batched SA steps on packed storage should match dense storage");
+}
+
+void test_sa_batched_reversals() {
+    const auto cities = random_instance(300, 41);
+    check_batched_reversals<std::int32_t>(cities);
+    check_batched_reversals<std::uint16_t>(cities);
+}
+
+void test_genetic_population_arena() {
+    for (const int population: {1, 2, 7, 40}) {
+        for (const bool two_opt: {false, true}) {
+            auto cities = random_instance(150, 43);
+            SolverContext context(43);
+            const SolveResult result = ga_solve(cities, GaParams{population, 0.3, two_opt}, iteration_limit(15), context);
+
+            expect(is_valid_tour(cities) && result.cost == total_cost(cities),
+                   "GA should return the best tour its population arena held");
+        }
+    }
+}
+
+// Order crossover as a plain std::vector<bool> loop, drawing the slice like the library.
+Tour reference_order_crossover(const Tour& parent1, const Tour& parent2, Rng& rng) {
+    const std::size_t n = parent1.size();
+    const std::size_t length = rng.between(1, n >= 3 ? n - 2 : 1);
+    const std::size_t start = rng.below(n - length + 1);
+
+    Tour child(n);
+    std::vector<bool> used(n, false);
+    for (std::size_t i = start; i < start + length; ++i) {
+        child[i] = parent1[i];
+        used[parent1[i]] = true;
+    }
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i >= start && i < start + length) {
+            continue;
+        }
+        while (used[parent2[next]]) {
+            ++next;
+        }
+        child[i] = parent2[next];
+        used[parent2[next]] = true;
+    }
+
+    return child;
+}
+
+// Every child edge found in neither parent must be among the edges the crossover reports.
+void expect_rewired_edges(const Tour& child, const Tour& parent1, const Tour& parent2,
+                          const CrossoverWorkspace& workspace) {
+    const std::size_t n = child.size();
+    auto in_parent = [n](const Tour& parent, std::uint32_t a, std::uint32_t b) {
+        const std::size_t i = static_cast<std::size_t>(std::find(parent.begin(), parent.end(), a) - parent.begin());
+        return parent[(i + 1) % n] == b || parent[(i + n - 1) % n] == b;
+    };
+
+    std::vector<bool> reported(n, false);
+    for (std::size_t k = 0; k < workspace.rewired_count; ++k) {
+        reported[workspace.rewired[k]] = true;
+    }
+    for (std::size_t p = 0; p < n && n > 1; ++p) {
+        const std::uint32_t a = child[(p + n - 1) % n];
+        const std::uint32_t b = child[p];
+        expect(reported[p] || in_parent(parent1, a, b) || in_parent(parent2, a, b),
+               "crossover should report every edge it rewired at n=" + std::to_string(n));
+    }
+}
+
+void test_genetic_crossover_scratch() {
+    // One workspace across sizes, starting near the stamp wrap-around, so the stamped path sees
+    // stale stamps, growth and a clear; sizes up to CROSSOVER_BITMASK_CITIES use the bitmask.
+    CrossoverWorkspace workspace;
+    workspace.stamp = std::numeric_limits<std::uint32_t>::max() - 5;
+    workspace.record_rewired = true;
+
+    for (const std::size_t n: {std::size_t{2}, std::size_t{3}, std::size_t{65}, CROSSOVER_BITMASK_CITIES,
+                               CROSSOVER_BITMASK_CITIES + 1, std::size_t{6000}}) {
+        Tour parent1(n);
+        std::iota(parent1.begin(), parent1.end(), std::uint32_t{0});
+        Tour parent2 = parent1;
+        Rng parents_rng(n);
+        shuffle_range(parent1.begin(), parent1.end(), parents_rng);
+        shuffle_range(parent2.begin(), parent2.end(), parents_rng);
+
+        Rng rng(47);
+        Rng reference_rng(47);
+        Tour child(n);
+        for (int i = 0; i < 10; ++i) {
+            genetic_order_crossover(parent1.data(), parent2.data(), n, child.data(), workspace, rng);
+            expect(child == reference_order_crossover(parent1, parent2, reference_rng),
+                   "crossover into caller storage should match the reference order crossover at n=" +
+                       std::to_string(n));
+            expect_rewired_edges(child, parent1, parent2, workspace);
+        }
+    }
+    expect(workspace.stamp < 100, "crossover stamps should restart after wrapping around");
+}
 }
 
 int main() {
@@ -556,7 +1617,9 @@ int main() {
         {"TSPLIB parser rejects duplicates", test_tsplib_parser_rejects_duplicates},
         {"TSPLIB parser rejects trailing coordinate data", test_tsplib_parser_rejects_trailing_coordinate_data},
         {"TSPLIB parser requires exact section tokens", test_tsplib_parser_requires_exact_section_tokens},
+        {"TSPLIB parser handles CRLF and unterminated lines", test_tsplib_parser_handles_crlf_and_unterminated_lines},
         {"distance and total cost", test_distance_and_total_cost},
+        {"distance storage selection", test_distance_storage_selection},
         {"matrix cost rejects invalid ids", test_matrix_cost_rejects_invalid_ids},
         {"tour validity", test_tour_validity},
         {"two-opt rejects invalid ids", test_two_opt_rejects_invalid_ids},
@@ -570,6 +1633,16 @@ int main() {
         {"SA config reads two-opt", test_sa_config_reads_two_opt},
         {"neighbor 2-opt reaches local optimum", test_neighbor_two_opt_reaches_local_optimum},
         {"bounded neighbor 2-opt is safe", test_bounded_neighbor_two_opt_is_safe},
+        {"index tour matches city tour", test_index_tour_matches_city_tour},
+        {"coordinate distance matches matrix", test_coordinate_distance_matches_matrix},
+        {"packed distance matrix matches dense", test_packed_distance_matrix_matches_dense},
+        {"k-d tree neighbor lists match scan", test_kd_tree_neighbor_lists_match_scan},
+        {"quadrant neighbor lists cover quadrants", test_quadrant_neighbor_lists_cover_quadrants},
+        {"alpha neighbor lists keep grid edges", test_alpha_neighbor_lists_keep_grid_edges},
+        {"vectorized distances match scalar", test_vectorized_distances_match_scalar},
+        {"Delaunay neighbor lists contain MST", test_delaunay_neighbor_lists_contain_mst},
+        {"instance cache round trip", test_instance_cache_round_trip},
+        {"distance budget selects coordinates", test_distance_budget_selects_coordinates},
         {"RunController detects stability", test_run_controller_detects_stability},
         {"RunController iteration limit is not stable", test_run_controller_iteration_limit_is_not_stable},
         {"RunController stable window", test_run_controller_stable_window},
@@ -577,7 +1650,20 @@ int main() {
         {"timed stop mode runs and stops", test_timed_mode_runs_and_stops},
         {"SA berlin52 reaches known optimum", test_sa_berlin52_reaches_known_optimum},
         {"SA stable mode uses restart stagnation", test_sa_stable_mode_uses_restart_stagnation},
-        {"derive_run_seed deterministic and distinct", test_derive_run_seed_is_deterministic_and_distinct}
+        {"derive_run_seed deterministic and distinct", test_derive_run_seed_is_deterministic_and_distinct},
+        {"solver contexts are independent", test_solver_contexts_are_independent},
+        {"prepared instance matches direct solve", test_prepared_instance_matches_direct_solve},
+        {"Or-opt moves segments back", test_or_opt_moves_segments_back},
+        {"Lin-Kernighan beats 2-opt", test_lin_kernighan_beats_two_opt},
+        {"two-level tour matches array", test_two_level_tour_matches_array},
+        {"local search workspace seeds", test_local_search_workspace_seeds},
+        {"SA neighbor moves", test_sa_neighbor_moves},
+        {"SA copies the best tour lazily", test_sa_copies_best_tour_lazily},
+        {"SA adaptive schedule", test_sa_adaptive_schedule},
+        {"SA parallel tempering", test_sa_parallel_tempering},
+        {"SA batched reversals", test_sa_batched_reversals},
+        {"GA population arena", test_genetic_population_arena},
+        {"GA crossover scratch", test_genetic_crossover_scratch}
     };
 
     for (const auto& [name, test]: tests) {